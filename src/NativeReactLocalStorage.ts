@@ -4,6 +4,22 @@ type V2Config = {
     id: string
     content: string 
 }
+type MemoryFootprint = {
+    sqliteHeapBytes: number
+    sqliteHeapHighwater: number
+    sqliteSoftHeapLimit: number
+    pageCacheKiB: number
+    // 所有缓存的占用之和，以及它们的预算之和
+    cacheBytes: number
+    cacheBudgetBytes: number
+    pressureLevel: number
+}
+type SubscriptionImport = {
+    imported: number
+    failed: number
+    duplicates: number
+    cacheHits: number
+}
 export interface Spec extends TurboModule {
   multiply(a: number, b: number): number;
   setItem(value: string, key: string): void;
@@ -32,6 +48,28 @@ export interface Spec extends TurboModule {
   addReward():void
   // 复制
   copyTheInviteCode(code: string): void;
+  // 数值/布尔存储 (SQLite 原生类型, 与 setItem 分开存放)
+  setDouble(value: number, key: string): void;
+  getDouble(key: string): number | null;
+  setInt64(value: number, key: string): void;
+  getInt64(key: string): number | null;
+  // 原子计数器, 返回新值; 已存值或 delta 不是 int64 整数、或结果溢出时返回 null 且不修改
+  incrementInt64(key: string, delta: number): number | null;
+  setBool(value: boolean, key: string): void;
+  getBool(key: string): boolean | null;
+  // 全文检索 (FTS5), 需先对 key 前缀开启索引
+  enableSearchIndex(prefix: string): void;
+  disableSearchIndex(prefix: string): void;
+  search(prefix: string, query: string, limit: number): Promise<string[]>;
+  // 从 AsyncStorage 导出的 JSON 文件批量导入, 返回导入条数
+  // 进度通过 StorageImportProgress 事件通知: { imported, bytesRead, totalBytes }
+  importAsyncStorageDump(path: string): Promise<number>;
+  // 内存压力: 0 正常, 1 中等, 2 严重
+  reportMemoryPressure(level: number): void;
+  // 当前存储层内存占用
+  getMemoryFootprint(): MemoryFootprint;
+  // 导入订阅（base64 或逐行链接），已解析过的链接从本地缓存读取
+  importSubscription(subscription: string): Promise<SubscriptionImport>;
 }
 
 export default TurboModuleRegistry.getEnforcing<Spec>('ReactLocalStorage');
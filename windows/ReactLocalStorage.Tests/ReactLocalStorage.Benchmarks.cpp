@@ -0,0 +1,465 @@
+#include "pch.h"
+#include <chrono>
+#include <filesystem>
+#include <regex>
+#include <sstream>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ReactLocalStorageTests
+{
+    namespace
+    {
+        // 典型订阅内容：vmess / vless / ss 混合
+        const std::vector<std::string>& ShareLinkCorpus() {
+            static const std::vector<std::string> corpus = {
+                "vmess://eyJ2IjoiMiIsInBzIjoiYmVuY2gtdm1lc3MiLCJhZGQiOiIxMDQuMjEuMzIuMSIsInBvcnQiOiI0NDMiLCJpZCI6ImI4MzEzODFkLTYzMjQtNGQ1My1hZDRmLThjZGE0OGIzMDgxMSIsImFpZCI6IjAiLCJzY3kiOiJhdXRvIiwibmV0Ijoid3MiLCJ0eXBlIjoibm9uZSIsImhvc3QiOiJleGFtcGxlLmNvbSIsInBhdGgiOiIvcmF5IiwidGxzIjoidGxzIiwic25pIjoiZXhhbXBsZS5jb20ifQ==",
+                "vless://af180fee-d7d8-4d34-de6e-b92dbc682005@146.235.231.101:35104?encryption=none&security=none&type=tcp&headerType=none#lv",
+                "vless://0b65bf1e-6e4f-4c1b-9d0b-7a3f2d1e9c11@cdn.example.com:443?encryption=none&security=tls&sni=cdn.example.com&fp=chrome&type=ws&host=cdn.example.com&path=%2Fvless%3Fed%3D2048#%E9%A6%99%E6%B8%AF%2001",
+                "ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8443#ss-sip002",
+                "ss://Y2hhY2hhMjAtaWV0Zi1wb2x5MTMwNTpzZWNyZXRAMjAzLjAuMTEzLjk6ODM4OA==#ss-legacy",
+            };
+            return corpus;
+        }
+
+        template <typename Fn>
+        double MeasureSeconds(Fn&& fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        void Report(const char* name, size_t items, double seconds, const char* unit) {
+            std::ostringstream os;
+            os << name << ": " << items << " " << unit << " in " << seconds * 1000.0 << " ms ("
+               << static_cast<uint64_t>(items / (seconds > 0 ? seconds : 1e-9)) << " " << unit << "/sec)";
+            Logger::WriteMessage(os.str().c_str());
+        }
+    }
+
+    TEST_CLASS(V2rayConfigBenchmarks)
+    {
+    public:
+        TEST_METHOD(ImportConfigThroughput) {
+            const auto& corpus = ShareLinkCorpus();
+            const size_t rounds = 20000;
+            size_t parsed = 0;
+
+            double seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    for (const auto& link : corpus) {
+                        if (V2rayConfigWin::AngConfigManager::importConfig(link)) ++parsed;
+                    }
+                }
+            });
+
+            Assert::AreEqual(rounds * corpus.size(), parsed);
+            Report("importConfig", parsed, seconds, "links");
+        }
+
+        TEST_METHOD(VmessExtractorThroughput) {
+            std::string payload;
+            Assert::IsTrue(static_cast<bool>(V2rayConfigWin::Utils::decode_base64(ShareLinkCorpus()[0].substr(8), payload)));
+            const size_t rounds = 200000;
+
+            // 对照：先构建 DOM，再逐个取成员
+            auto member = [](const nlohmann::json& dom, const char* key) {
+                auto it = dom.find(key);
+                if (it == dom.end() || it->is_null()) return std::string();
+                return it->is_string() ? it->get<std::string>() : it->dump();
+            };
+            V2rayConfigWin::VmessQRCode viaDom;
+            double domSeconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    const auto dom = nlohmann::json::parse(payload);
+                    viaDom.ps = member(dom, "ps");
+                    viaDom.add = member(dom, "add");
+                    viaDom.port = member(dom, "port");
+                    viaDom.id = member(dom, "id");
+                    viaDom.net = member(dom, "net");
+                    viaDom.host = member(dom, "host");
+                    viaDom.path = member(dom, "path");
+                    viaDom.tls = member(dom, "tls");
+                    viaDom.sni = member(dom, "sni");
+                }
+            });
+            Report("vmess json::parse + get", rounds, domSeconds, "payloads");
+
+            V2rayConfigWin::VmessQRCode onDemand;
+            double scanSeconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    onDemand = V2rayConfigWin::VmessQRCode{};
+                    V2rayConfigWin::extract_vmess_fields(payload, onDemand);
+                }
+            });
+            Report("vmess extract_vmess_fields", rounds, scanSeconds, "payloads");
+
+            Assert::AreEqual(viaDom.add, onDemand.add);
+            Assert::AreEqual(viaDom.port, onDemand.port);
+            Assert::AreEqual(viaDom.id, onDemand.id);
+            Assert::AreEqual(viaDom.path, onDemand.path);
+        }
+
+        TEST_METHOD(ImportBatchThroughput) {
+            const auto& corpus = ShareLinkCorpus();
+            std::string subscription;
+            const size_t rounds = 20000;
+            for (size_t i = 0; i < rounds; ++i) {
+                for (const auto& link : corpus) {
+                    subscription += link;
+                    subscription += '\n';
+                }
+            }
+
+            for (size_t threads : { size_t(1), size_t(0) }) {
+                V2rayConfigWin::AngConfigManager::BatchImportResult result;
+                double seconds = MeasureSeconds([&] {
+                    result = V2rayConfigWin::AngConfigManager::importBatch(subscription, threads, /*deduplicate=*/false);
+                });
+                Assert::AreEqual(rounds * corpus.size(), result.configs.size());
+                Report(threads == 1 ? "importBatch (1 thread)" : "importBatch (all cores)", result.configs.size(), seconds, "links");
+            }
+
+            // 去重：语料每轮重复，只保留第一轮
+            V2rayConfigWin::AngConfigManager::BatchImportResult deduped;
+            double seconds = MeasureSeconds([&] {
+                deduped = V2rayConfigWin::AngConfigManager::importBatch(subscription);
+            });
+            Assert::AreEqual(corpus.size(), deduped.configs.size());
+            Assert::AreEqual((rounds - 1) * corpus.size(), deduped.merges.size());
+            Report("importBatch (dedup, all cores)", rounds * corpus.size(), seconds, "links");
+        }
+
+        TEST_METHOD(IpClassifierThroughput) {
+            // 路由规则中常见的写法
+            const std::vector<std::string> rules = {
+                "8.8.8.8", "10.0.0.0/8", "192.168.1.1", "2001:db8::1", "[::1]", "fc00::/7",
+                "geoip:cn", "domain:example.com", "full:www.google.com", "regexp:.*\\.cn$",
+            };
+            const size_t rounds = 100000;
+            size_t matches = 0;
+            double seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    for (const auto& rule : rules) {
+                        if (V2rayConfigWin::Utils::is_ip_address(rule)) ++matches;
+                    }
+                }
+            });
+            Assert::AreEqual(rounds * 6, matches);
+            Report("is_ip_address", rounds * rules.size(), seconds, "rules");
+
+            // 对照：旧实现每次调用都构造 std::regex
+            const size_t regexRounds = rounds / 100;
+            size_t regexMatches = 0;
+            double regexSeconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < regexRounds; ++i) {
+                    for (const auto& rule : rules) {
+                        std::regex ip_pattern(R"(^(\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3})|(\[([0-9a-fA-F:]+)\])$)");
+                        if (std::regex_match(rule, ip_pattern)) ++regexMatches;
+                    }
+                }
+            });
+            Report("std::regex baseline", regexRounds * rules.size(), regexSeconds, "rules");
+        }
+
+        TEST_METHOD(ServerTableFootprint) {
+            const auto& corpus = ShareLinkCorpus();
+            const size_t rounds = 20000;
+            std::vector<V2rayConfigWin::ServerConfig> configs;
+            configs.reserve(rounds * corpus.size());
+            for (size_t i = 0; i < rounds; ++i) {
+                for (const auto& link : corpus) {
+                    configs.push_back(*V2rayConfigWin::AngConfigManager::importConfig(link));
+                    configs.back().remarks += std::to_string(i);
+                }
+            }
+
+            V2rayConfigWin::ServerTable table;
+            double seconds = MeasureSeconds([&] { table.addAll(configs); });
+            Report("ServerTable::add", table.size(), seconds, "rows");
+
+            std::ostringstream os;
+            os << "ServerTable: " << table.size() << " rows, " << table.memoryBytes() << " bytes ("
+               << table.memoryBytes() / table.size() << " bytes/row)";
+            Logger::WriteMessage(os.str().c_str());
+
+            size_t restored = 0;
+            seconds = MeasureSeconds([&] {
+                for (V2rayConfigWin::ServerTable::Row row = 0; row < table.size(); ++row) {
+                    restored += table.toServerConfig(row).outboundBean.has_value();
+                }
+            });
+            Assert::AreEqual(table.size(), restored);
+            Report("ServerTable::toServerConfig", restored, seconds, "rows");
+        }
+
+        TEST_METHOD(GenerateLatency) {
+            const auto config = *V2rayConfigWin::AngConfigManager::importConfig(ShareLinkCorpus()[2]);
+            const V2rayConfigWin::V2rayGeneratorSettings settings;
+            const size_t rounds = 5000;
+
+            // 首次调用包含模板解析
+            std::optional<std::string> generated;
+            double first = MeasureSeconds([&] { generated = V2rayConfigWin::V2rayConfigGenerator::generate(config, settings); });
+            Assert::IsTrue(generated.has_value());
+            Report("generate (first call)", 1, first, "configs");
+
+            double seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    generated = V2rayConfigWin::V2rayConfigGenerator::generate(config, settings);
+                }
+            });
+            Assert::IsTrue(generated.has_value());
+            Report("generate", rounds, seconds, "configs");
+
+            // 对照：旧实现每次调用都要付出的模板解析开销
+            V2rayConfigWin::V2rayFullConfig::Config base;
+            double parseSeconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    base = nlohmann::json::parse(V2rayConfigWin::V2rayConfigGenerator::kBaseConfigTemplate).get<V2rayConfigWin::V2rayFullConfig::Config>();
+                }
+            });
+            Report("base template parse (per call, before)", rounds, parseSeconds, "configs");
+        }
+
+        TEST_METHOD(ConfigSerialization) {
+            // 与 generate 内部相同的 Config：基础模板加一个代理出站
+            V2rayConfigWin::V2rayFullConfig::Config config = V2rayConfigWin::V2rayConfigGenerator::detail::base_config();
+            nlohmann::json outbound = V2rayConfigWin::AngConfigManager::importConfig(ShareLinkCorpus()[2])->outboundBean;
+            outbound["tag"] = "proxy";
+            config.outbounds.insert(config.outbounds.begin(), outbound);
+            const size_t rounds = 20000;
+
+            std::string viaDom;
+            double domSeconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    viaDom = nlohmann::json(config).dump(2);
+                }
+            });
+            Report("json(config).dump(2)", rounds, domSeconds, "configs");
+
+            std::string buffer;
+            double writerSeconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    buffer.clear();
+                    V2rayConfigWin::JsonWriter writer(buffer);
+                    V2rayConfigWin::V2rayFullConfig::write_json(writer, config);
+                }
+            });
+            Report("JsonWriter (compact, reused buffer)", rounds, writerSeconds, "configs");
+
+            std::ostringstream os;
+            os << "config size: " << viaDom.size() << " bytes pretty, " << buffer.size() << " bytes compact";
+            Logger::WriteMessage(os.str().c_str());
+            Assert::AreEqual(nlohmann::json::parse(viaDom).dump(), buffer);
+        }
+
+        TEST_METHOD(GenerateBatchThroughput) {
+            // 测速场景：数百个服务器共用同一份设置
+            const auto& corpus = ShareLinkCorpus();
+            std::vector<V2rayConfigWin::ServerConfig> servers;
+            for (size_t i = 0; i < 100; ++i) {
+                for (const auto& link : corpus) servers.push_back(*V2rayConfigWin::AngConfigManager::importConfig(link));
+            }
+            const V2rayConfigWin::V2rayGeneratorSettings settings;
+
+            std::vector<std::optional<std::string>> single(servers.size());
+            double seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < servers.size(); ++i) {
+                    single[i] = V2rayConfigWin::V2rayConfigGenerator::generate(servers[i], settings);
+                }
+            });
+            Report("generate (one by one)", servers.size(), seconds, "configs");
+
+            for (size_t threads : { size_t(1), size_t(0) }) {
+                std::vector<std::optional<std::string>> batch;
+                seconds = MeasureSeconds([&] { batch = V2rayConfigWin::V2rayConfigGenerator::generate_batch(servers, settings, threads); });
+                Assert::IsTrue(batch == single);
+                Report(threads == 1 ? "generate_batch (1 thread)" : "generate_batch (all cores)", batch.size(), seconds, "configs");
+            }
+        }
+
+        TEST_METHOD(ConfigCacheHit) {
+            // 在几个常用服务器之间来回切换
+            const auto& corpus = ShareLinkCorpus();
+            std::vector<V2rayConfigWin::ServerConfig> servers;
+            for (const auto& link : corpus) servers.push_back(*V2rayConfigWin::AngConfigManager::importConfig(link));
+            const V2rayConfigWin::V2rayGeneratorSettings settings;
+            const size_t kSwitches = 2000;
+
+            double seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < kSwitches; ++i) V2rayConfigWin::V2rayConfigGenerator::generate(servers[i % servers.size()], settings);
+            });
+            Report("generate (uncached)", kSwitches, seconds, "configs");
+
+            V2rayConfigWin::ConfigCache cache;
+            seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < kSwitches; ++i) cache.generate(servers[i % servers.size()], settings);
+            });
+            Assert::AreEqual(kSwitches - servers.size(), cache.hits());
+            Report("ConfigCache::generate", kSwitches, seconds, "configs");
+        }
+
+        TEST_METHOD(IncrementalSettingsChange) {
+            // 用户来回切换分流模式
+            auto server = *V2rayConfigWin::AngConfigManager::importConfig(ShareLinkCorpus().front());
+            V2rayConfigWin::V2rayGeneratorSettings settings;
+            const size_t kChanges = 2000;
+
+            double seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < kChanges; ++i) {
+                    settings.routingMode = static_cast<V2rayConfigWin::ERoutingMode>(i % 5);
+                    V2rayConfigWin::V2rayConfigGenerator::generate(server, settings);
+                }
+            });
+            Report("generate (full)", kChanges, seconds, "configs");
+
+            V2rayConfigWin::V2rayConfigGenerator::IncrementalGenerator generator;
+            generator.generate(server, settings);
+            seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < kChanges; ++i) {
+                    settings.routingMode = static_cast<V2rayConfigWin::ERoutingMode>(i % 5);
+                    generator.update(settings);
+                }
+            });
+            Report("IncrementalGenerator::update", kChanges, seconds, "configs");
+        }
+
+        TEST_METHOD(RoutingRuleCompile) {
+            // 数万条用户规则：首次编译，之后按文本哈希命中缓存
+            std::ostringstream text;
+            for (int i = 0; i < 20000; ++i) {
+                text << "domain:site" << i % 15000 << ".example.com, ";
+                text << "10." << (i >> 8) % 256 << "." << i % 256 << ".0/24, ";
+            }
+            const std::string rules = text.str();
+
+            V2rayConfigWin::RoutingRules::clear_compile_cache();
+            std::shared_ptr<const V2rayConfigWin::RoutingRules::CompiledRules> compiled;
+            double seconds = MeasureSeconds([&] { compiled = V2rayConfigWin::RoutingRules::compile_cached(rules); });
+            Report("compile rules (cold)", 40000, seconds, "entries");
+            seconds = MeasureSeconds([&] { compiled = V2rayConfigWin::RoutingRules::compile_cached(rules); });
+            Report("compile rules (cached)", 40000, seconds, "entries");
+
+            std::ostringstream os;
+            os << "compiled rules: " << compiled->domains.size() << " domains, " << compiled->ips.size() << " ip entries from 40000";
+            Logger::WriteMessage(os.str().c_str());
+        }
+
+        TEST_METHOD(ObservatoryConfig) {
+            // 一个核心实例测全部服务器，代替每台服务器各启动一次
+            const auto& corpus = ShareLinkCorpus();
+            std::vector<V2rayConfigWin::ServerConfig> servers;
+            for (size_t i = 0; i < 100; ++i) {
+                for (const auto& link : corpus) servers.push_back(*V2rayConfigWin::AngConfigManager::importConfig(link));
+            }
+            const V2rayConfigWin::V2rayGeneratorSettings settings;
+
+            std::optional<V2rayConfigWin::V2rayConfigGenerator::ObservatoryConfig> result;
+            double seconds = MeasureSeconds([&] { result = V2rayConfigWin::V2rayConfigGenerator::generate_observatory(servers, settings); });
+            Assert::IsTrue(result.has_value());
+            Report("generate_observatory", servers.size(), seconds, "servers");
+
+            std::ostringstream os;
+            os << "observatory config: " << result->config.size() << " bytes for " << servers.size() << " servers, 1 core instance";
+            Logger::WriteMessage(os.str().c_str());
+        }
+
+        TEST_METHOD(GeoIndexLookup) {
+            // 约 2000 个分类、数 MB 的 geosite.dat：映射并建索引一次，之后校验规则只查哈希表
+            auto varint = [](std::string& out, size_t value) {
+                for (; value >= 0x80; value >>= 7) out += static_cast<char>((value & 0x7F) | 0x80);
+                out += static_cast<char>(value);
+            };
+            std::string data;
+            const std::string payload(2048, 'x');
+            for (int i = 0; i < 2000; ++i) {
+                const std::string code = "category-" + std::to_string(i);
+                std::string entry = "\x0a";
+                varint(entry, code.size());
+                entry += code + "\x12";
+                varint(entry, payload.size());
+                entry += payload;
+                data += "\x0a";
+                varint(data, entry.size());
+                data += entry;
+            }
+            const auto path = std::filesystem::temp_directory_path() / "react_local_storage_bench_geosite.dat";
+            {
+                std::ofstream(path, std::ios::binary | std::ios::trunc) << data;
+            }
+
+            V2rayConfigWin::GeoIndex index;
+            double seconds = MeasureSeconds([&] { Assert::IsTrue(index.openGeosite(path)); });
+            Report("GeoIndex::openGeosite", index.geositeCount(), seconds, "categories");
+
+            const size_t kLookups = 100000;
+            size_t found = 0;
+            seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < kLookups; ++i) found += index.hasGeosite("category-" + std::to_string(i % 4000));
+            });
+            Assert::AreEqual(kLookups / 2, found);
+            Report("GeoIndex::hasGeosite", kLookups, seconds, "lookups");
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(ServerCacheWarmImport) {
+            // 备注各不相同（指纹不含备注，故关闭去重），模拟刷新一个大订阅
+            const auto& corpus = ShareLinkCorpus();
+            const size_t rounds = 20000;
+            std::string subscription;
+            for (size_t i = 0; i < rounds; ++i) {
+                for (size_t j = 1; j < corpus.size(); ++j) {
+                    subscription += corpus[j];
+                    subscription += std::to_string(i);
+                    subscription += '\n';
+                }
+            }
+            const size_t links = rounds * (corpus.size() - 1);
+            const auto path = std::filesystem::temp_directory_path() / "react_local_storage_bench_cache.bin";
+
+            V2rayConfigWin::ServerCache cache(links);
+            V2rayConfigWin::AngConfigManager::BatchImportResult cold;
+            double seconds = MeasureSeconds([&] { cold = V2rayConfigWin::AngConfigManager::importBatch(subscription, 0, /*deduplicate=*/false, &cache); });
+            Assert::AreEqual(links, cold.configs.size());
+            Report("importBatch (cold cache)", links, seconds, "links");
+
+            seconds = MeasureSeconds([&] { Assert::IsTrue(static_cast<bool>(cache.save(path))); });
+            Report("ServerCache::save", cache.size(), seconds, "rows");
+
+            V2rayConfigWin::ServerCache loaded(links);
+            seconds = MeasureSeconds([&] { Assert::IsTrue(static_cast<bool>(loaded.load(path))); });
+            Report("ServerCache::load", loaded.size(), seconds, "rows");
+
+            V2rayConfigWin::AngConfigManager::BatchImportResult warm;
+            seconds = MeasureSeconds([&] { warm = V2rayConfigWin::AngConfigManager::importBatch(subscription, 0, /*deduplicate=*/false, &loaded); });
+            Assert::AreEqual(links, warm.cacheHits);
+            Report("importBatch (warm cache)", links, seconds, "links");
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(DecodeBase64Throughput) {
+            std::mt19937 rng(42);
+            std::string payload(1 << 20, '\0');
+            for (auto& c : payload) c = static_cast<char>(rng());
+            // 用 Windows CryptoAPI 编码，避免依赖被测实现
+            DWORD size = 0;
+            CryptBinaryToStringA(reinterpret_cast<const BYTE*>(payload.data()), static_cast<DWORD>(payload.size()), CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF, NULL, &size);
+            std::string encoded(size, '\0');
+            CryptBinaryToStringA(reinterpret_cast<const BYTE*>(payload.data()), static_cast<DWORD>(payload.size()), CRYPT_STRING_BASE64 | CRYPT_STRING_NOCRLF, encoded.data(), &size);
+            encoded.resize(size);
+
+            const size_t rounds = 50;
+            std::string decoded;
+            double seconds = MeasureSeconds([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    decoded.clear();
+                    Assert::IsTrue(static_cast<bool>(V2rayConfigWin::Utils::decode_base64(encoded, decoded)));
+                }
+            });
+
+            Assert::IsTrue(decoded == payload);
+            Report("decode_base64", rounds * (payload.size() >> 20), seconds, "MiB");
+        }
+    };
+}
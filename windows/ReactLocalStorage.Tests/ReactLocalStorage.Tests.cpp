@@ -1,8 +1,14 @@
 #include "pch.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <winsqlite/winsqlite3.h>
 // Link against the necessary system libraries.
 // This is easier than changing project settings.
 #pragma comment(lib, "bcrypt.lib")
 #pragma comment(lib, "crypt32.lib")
+#pragma comment(lib, "winsqlite3.lib")
 
 
 // This is the new version of the function without OpenSSL dependency.
@@ -113,5 +119,1030 @@ namespace ReactLocalStorageTests
             std::string startResult = v2rayManager.StartV2RayPoint(handle, false, domain, configStrOpt.value());
             std::cout << "StartV2RayPoint command sent successfully: " << startResult << std::endl;
         }
+
+        TEST_METHOD(TestShadowsocksLinkParsing){
+            // SIP002：userinfo 单独 base64，密码中允许出现 ':' 和 '@'
+            auto sip002 = V2rayConfigWin::AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8443#ss%20one");
+            Assert::IsTrue(sip002.has_value());
+            const auto& server = sip002->outboundBean->settings->servers->at(0);
+            Assert::AreEqual(std::string("aes-256-gcm"), server.method);
+            Assert::AreEqual(std::string("p@ss:word"), server.password);
+            Assert::AreEqual(std::string("198.51.100.7"), server.address);
+            Assert::AreEqual(8443, server.port);
+            Assert::AreEqual(std::string("ss one"), sip002->remarks);
+
+            // 旧格式：整体 base64
+            auto legacy = V2rayConfigWin::AngConfigManager::importConfig("ss://Y2hhY2hhMjAtaWV0Zi1wb2x5MTMwNTpzZWNyZXRAMjAzLjAuMTEzLjk6ODM4OA==");
+            Assert::IsTrue(legacy.has_value());
+            Assert::AreEqual(std::string("203.0.113.9"), legacy->outboundBean->settings->servers->at(0).address);
+            Assert::AreEqual(8388, legacy->outboundBean->settings->servers->at(0).port);
+
+            Assert::IsFalse(V2rayConfigWin::AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cGFzcw==@host:port").has_value());
+        }
+
+        TEST_METHOD(TestBase64Decoding){
+            using namespace V2rayConfigWin::Utils;
+            // 超过 32 字节以覆盖 SIMD 路径；标准与 URL 安全字母表、可省略填充
+            const std::string plain = "{\"add\":\"example.com\",\"port\":\"443\",\"id\":\"b831381d\"}?>";
+            auto decode = [](std::string_view in) {
+                std::string decoded;
+                Assert::IsTrue(static_cast<bool>(decode_base64(in, decoded)));
+                return decoded;
+            };
+            Assert::AreEqual(plain, decode("eyJhZGQiOiJleGFtcGxlLmNvbSIsInBvcnQiOiI0NDMiLCJpZCI6ImI4MzEzODFkIn0/Pg=="));
+            Assert::AreEqual(plain, decode("eyJhZGQiOiJleGFtcGxlLmNvbSIsInBvcnQiOiI0NDMiLCJpZCI6ImI4MzEzODFkIn0_Pg"));
+            Assert::AreEqual(plain, decode("eyJhZGQiOiJleGFtcGxlLmNvbSIsInBvcnQiOiI0\r\nNDMiLCJpZCI6ImI4MzEzODFkIn0/Pg=="));
+
+            std::string out;
+            auto bad = decode_base64("eyJhZGQiOiJleGFtcGxlLmNvbSIsInBvcnQi*iI0NDMi", out);
+            Assert::IsTrue(bad.error == Base64Error::InvalidCharacter);
+            Assert::AreEqual(size_t(36), bad.offset);
+
+            out.clear();
+            Assert::IsTrue(decode_base64("QQ=", out).error == Base64Error::InvalidPadding);
+            out.clear();
+            Assert::IsTrue(decode_base64("QUJD+", out).error == Base64Error::TruncatedInput);
+            out.clear();
+            Assert::IsFalse(static_cast<bool>(decode_base64("ab-_", out, Base64Alphabet::Standard)));
+        }
+
+        TEST_METHOD(TestBatchImport){
+            using namespace V2rayConfigWin::AngConfigManager;
+            // 多线程解析后结果仍按输入顺序排列，空行被忽略
+            std::string subscription;
+            for (int i = 0; i < 100; ++i) {
+                subscription += "vless://af180fee-d7d8-4d34-de6e-b92dbc682005@146.235.231.101:" + std::to_string(10000 + i) + "?type=tcp#n" + std::to_string(i) + "\r\n";
+                subscription += "trojan://secret@example.com:443\n\n";
+                subscription += "vless://missing-host\n";
+            }
+            auto result = importBatch(subscription, 4);
+            Assert::AreEqual(size_t(300), result.status.size());
+            Assert::AreEqual(size_t(100), result.configs.size());
+            for (int i = 0; i < 100; ++i) {
+                Assert::IsTrue(result.status[i * 3] == ImportStatus::Ok);
+                Assert::IsTrue(result.status[i * 3 + 1] == ImportStatus::UnsupportedProtocol);
+                Assert::IsTrue(result.status[i * 3 + 2] == ImportStatus::MissingField);
+                Assert::AreEqual("n" + std::to_string(i), result.configs[i].remarks);
+            }
+
+            // 整体 base64 编码的订阅
+            auto blob = importBatch("dmxlc3M6Ly9hZjE4MGZlZS1kN2Q4LTRkMzQtZGU2ZS1iOTJkYmM2ODIwMDVAMTQ2LjIzNS4yMzEuMTAxOjM1MTA0I2x2CnRyb2phbjovL3hAeToxCg==");
+            Assert::AreEqual(size_t(2), blob.status.size());
+            Assert::AreEqual(size_t(1), blob.configs.size());
+            Assert::AreEqual(std::string("lv"), blob.configs[0].remarks);
+        }
+
+        TEST_METHOD(TestParallelChunksRethrows){
+            using namespace V2rayConfigWin;
+            // 某个分块抛出异常时不再领取新分块，所有线程结束后在调用线程重新抛出
+            std::atomic<size_t> processed{0};
+            bool thrown = false;
+            try {
+                Utils::parallel_chunks(1000, 4, 10, [&](size_t begin, size_t end) {
+                    if (begin == 500) throw std::bad_alloc();
+                    processed += end - begin;
+                });
+            } catch (const std::bad_alloc&) {
+                thrown = true;
+            }
+            Assert::IsTrue(thrown);
+            Assert::IsTrue(processed < 1000);
+
+            processed = 0;
+            Utils::parallel_chunks(1000, 4, 10, [&](size_t begin, size_t end) { processed += end - begin; });
+            Assert::AreEqual(size_t(1000), processed.load());
+        }
+
+        TEST_METHOD(TestSubscriptionStream){
+            using namespace V2rayConfigWin::AngConfigManager;
+            std::string subscription;
+            for (int i = 0; i < 100; ++i) {
+                subscription += "vless://af180fee-d7d8-4d34-de6e-b92dbc682005@146.235.231.101:" + std::to_string(10000 + i) + "?type=tcp#n" + std::to_string(i) + "\n";
+                subscription += "trojan://secret@example.com:443\n";
+            }
+            // CryptoAPI 编码，每 64 字符换行，模拟下载到本地的订阅文件
+            DWORD size = 0;
+            CryptBinaryToStringA(reinterpret_cast<const BYTE*>(subscription.data()), static_cast<DWORD>(subscription.size()), CRYPT_STRING_BASE64, NULL, &size);
+            std::string encoded(size, '\0');
+            CryptBinaryToStringA(reinterpret_cast<const BYTE*>(subscription.data()), static_cast<DWORD>(subscription.size()), CRYPT_STRING_BASE64, encoded.data(), &size);
+            encoded.resize(size);
+            const auto path = std::filesystem::temp_directory_path() / "react_local_storage_subscription.txt";
+            std::ofstream(path, std::ios::binary | std::ios::trunc).write(encoded.data(), encoded.size());
+
+            // 以很小的块推入，行和 base64 分组都会跨块
+            std::vector<V2rayConfigWin::ServerConfig> configs;
+            std::vector<size_t> failedLines;
+            SubscriptionStream stream(
+                [&](V2rayConfigWin::ServerConfig&& config) { configs.push_back(std::move(config)); },
+                [&](size_t line, ImportResult result) {
+                    Assert::IsTrue(result.status == ImportStatus::UnsupportedProtocol);
+                    failedLines.push_back(line);
+                });
+            std::ifstream in(path, std::ios::binary);
+            char chunk[7];
+            while (in.read(chunk, sizeof chunk) || in.gcount() > 0) {
+                Assert::IsTrue(stream.push(std::string_view(chunk, static_cast<size_t>(in.gcount()))));
+            }
+            Assert::IsTrue(stream.finish());
+            in.close();
+            std::filesystem::remove(path);
+
+            Assert::IsTrue(stream.isBase64());
+            Assert::AreEqual(size_t(200), stream.lines());
+            Assert::AreEqual(size_t(100), configs.size());
+            Assert::AreEqual(size_t(100), failedLines.size());
+            auto batch = importBatch(encoded, 1, false);
+            for (size_t i = 0; i < configs.size(); ++i) {
+                Assert::AreEqual(batch.configs[i].remarks, configs[i].remarks);
+                Assert::IsTrue(V2rayConfigWin::fingerprint(batch.configs[i]) == V2rayConfigWin::fingerprint(configs[i]));
+            }
+
+            // 解码失败时报告原始流中的位置
+            SubscriptionStream broken([](V2rayConfigWin::ServerConfig&&) {});
+            const std::string bad = encoded.substr(0, 100) + "*" + encoded.substr(100);
+            Assert::IsTrue(broken.push(bad.substr(0, 90)));
+            Assert::IsFalse(broken.push(bad.substr(90)));
+            Assert::AreEqual(size_t(100), broken.error().offset);
+        }
+
+        TEST_METHOD(TestFingerprintDedup){
+            using namespace V2rayConfigWin;
+            // 备注不同、主机名大小写不同的同一服务器视为重复
+            auto a = AngConfigManager::importConfig("vless://uuid@Example.COM:443?type=tcp#first");
+            auto b = AngConfigManager::importConfig("vless://uuid@example.com.:443#second");
+            auto c = AngConfigManager::importConfig("vless://uuid@example.com:8443#third");
+            Assert::IsTrue(fingerprint(*a) == fingerprint(*b));
+            Assert::IsTrue(fingerprint(*a) != fingerprint(*c));
+            Assert::AreEqual(size_t(32), fingerprint(*a).to_hex().size());
+
+            auto result = AngConfigManager::importBatch(
+                "vless://uuid@Example.COM:443?type=tcp#first\n"
+                "vless://uuid@example.com:8443#third\n"
+                "vless://uuid@example.com.:443#second\n");
+            Assert::AreEqual(size_t(2), result.configs.size());
+            Assert::AreEqual(std::string("first"), result.configs[0].remarks);
+            Assert::AreEqual(size_t(1), result.merges.size());
+            Assert::AreEqual(size_t(2), result.merges[0].line);
+            Assert::AreEqual(size_t(0), result.merges[0].keptLine);
+            Assert::IsTrue(result.status[2] == AngConfigManager::ImportStatus::Duplicate);
+        }
+
+        TEST_METHOD(TestServerTableRoundTrip){
+            using namespace V2rayConfigWin;
+            const char* links[] = {
+                "vless://0b65bf1e@cdn.example.com:443?encryption=none&security=tls&sni=cdn.example.com&fp=chrome&alpn=h2,http/1.1&type=ws#hk",
+                "ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8443#ss",
+            };
+            ServerTable table;
+            std::vector<ServerConfig> originals;
+            for (const char* link : links) {
+                originals.push_back(*AngConfigManager::importConfig(link));
+                table.add(originals.back());
+            }
+
+            Assert::AreEqual(size_t(2), table.size());
+            Assert::AreEqual(std::string("cdn.example.com"), std::string(table.address(0)));
+            Assert::AreEqual(8443, table.port(1));
+            for (ServerTable::Row row = 0; row < table.size(); ++row) {
+                // 按需还原的 ServerConfig 与原始对象一致
+                ServerConfig restored = table.toServerConfig(row);
+                Assert::IsTrue(nlohmann::json(*originals[row].outboundBean) == nlohmann::json(*restored.outboundBean));
+                Assert::AreEqual(originals[row].remarks, restored.remarks);
+                Assert::IsTrue(fingerprint(originals[row]) == fingerprint(restored));
+            }
+        }
+
+        TEST_METHOD(TestServerCachePersistence){
+            using namespace V2rayConfigWin;
+            const std::string subscription =
+                "vless://0b65bf1e@cdn.example.com:443?encryption=none&security=tls&sni=cdn.example.com&type=ws#hk\n"
+                "ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8443#ss\n"
+                "trojan://secret@example.com:443\n";
+            const auto path = std::filesystem::temp_directory_path() / "react_local_storage_server_cache.bin";
+
+            ServerCache cache;
+            auto cold = AngConfigManager::importBatch(subscription, 1, true, &cache);
+            Assert::AreEqual(size_t(0), cold.cacheHits);
+            Assert::AreEqual(size_t(2), cache.size());
+            Assert::IsTrue(static_cast<bool>(cache.save(path)));
+
+            // 重新加载后，同一订阅全部命中缓存，结果与首次解析一致
+            ServerCache loaded;
+            Assert::IsTrue(static_cast<bool>(loaded.load(path)));
+            auto warm = AngConfigManager::importBatch(subscription, 1, true, &loaded);
+            Assert::AreEqual(size_t(2), warm.cacheHits);
+            Assert::IsTrue(warm.status[2] == AngConfigManager::ImportStatus::UnsupportedProtocol);
+            for (size_t i = 0; i < cold.configs.size(); ++i) {
+                Assert::IsTrue(fingerprint(cold.configs[i]) == fingerprint(warm.configs[i]));
+            }
+
+            // 版本号不符或内容损坏的文件被丢弃
+            std::string bytes;
+            {
+                std::ifstream in(path, std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(in), {});
+            }
+            const std::pair<size_t, CacheFileStatus> damages[] = { { 4, CacheFileStatus::Stale }, { bytes.size() - 1, CacheFileStatus::ChecksumMismatch } };
+            for (const auto& [offset, status] : damages) {
+                std::string damaged = bytes;
+                damaged[offset] ^= 0x01;
+                std::ofstream(path, std::ios::binary | std::ios::trunc).write(damaged.data(), damaged.size());
+                ServerCache rejected;
+                Assert::IsTrue(rejected.load(path).status == status);
+                Assert::AreEqual(size_t(0), rejected.size());
+            }
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(TestServerCacheEviction){
+            using namespace V2rayConfigWin;
+            auto link = [](int i) { return "ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:" + std::to_string(8000 + i) + "#s" + std::to_string(i); };
+            ServerCache cache(4);
+            for (int i = 0; i < 4; ++i) cache.store(link(i), *AngConfigManager::importConfig(link(i)));
+
+            // 超出容量时淘汰最久未使用的链接，查询也算使用
+            ServerConfig config;
+            Assert::IsTrue(cache.lookup(link(0), config));
+            cache.store(link(4), *AngConfigManager::importConfig(link(4)));
+            Assert::AreEqual(size_t(4), cache.size());
+            Assert::IsFalse(cache.lookup(link(1), config));
+            Assert::IsTrue(cache.lookup(link(0), config));
+            Assert::AreEqual(8000, config.outboundBean->settings->servers->at(0).port);
+            Assert::IsTrue(cache.lookup(link(4), config));
+            Assert::AreEqual(8004, config.outboundBean->settings->servers->at(0).port);
+            Assert::IsTrue(cache.lookup(link(2), config));
+
+            // 保存时按使用先后排列，重新加载后仍按此淘汰
+            const auto path = std::filesystem::temp_directory_path() / "react_local_storage_server_cache_lru.bin";
+            Assert::IsTrue(static_cast<bool>(cache.save(path)));
+            ServerCache loaded(2);
+            Assert::IsTrue(static_cast<bool>(loaded.load(path)));
+            Assert::AreEqual(size_t(2), loaded.size());
+            Assert::IsTrue(loaded.lookup(link(4), config));
+            Assert::IsTrue(loaded.lookup(link(2), config));
+            Assert::IsFalse(loaded.lookup(link(0), config));
+
+            // 内存压力下的淘汰不标记 dirty；之后保存时文件仍保留被淘汰的链接，再按容量淘汰
+            cache.trimToBytes(0);
+            Assert::AreEqual(size_t(0), cache.size());
+            Assert::IsFalse(cache.dirty());
+            cache.store(link(5), *AngConfigManager::importConfig(link(5)));
+            Assert::IsTrue(static_cast<bool>(cache.save(path)));
+            Assert::AreEqual(size_t(1), cache.size());
+            ServerCache reloaded(4);
+            Assert::IsTrue(static_cast<bool>(reloaded.load(path)));
+            Assert::AreEqual(size_t(4), reloaded.size());
+            Assert::IsTrue(reloaded.lookup(link(5), config));
+            Assert::IsTrue(reloaded.lookup(link(0), config));
+            Assert::IsFalse(reloaded.lookup(link(3), config));
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(TestConfigWriter){
+            using namespace V2rayConfigWin;
+            auto server = *AngConfigManager::importConfig("vless://0b65bf1e@cdn.example.com:443?encryption=none&security=tls&sni=cdn.example.com&fp=chrome&type=ws#hk");
+            V2rayGeneratorSettings settings;
+            settings.routingMode = ERoutingMode::BYPASS_LAN_MAINLAND;
+            settings.fakeDnsEnabled = true;
+            settings.userRoutingDirect = "geoip:cn, 10.0.0.0/8, domain:example.com";
+
+            // 默认输出紧凑格式，内容与 DOM 序列化一致
+            std::string compact;
+            Assert::IsTrue(V2rayConfigGenerator::generate_into(server, settings, compact));
+            Assert::AreEqual(nlohmann::json::parse(compact).dump(), compact);
+
+            // 调试用的缩进格式与 dump(2) 逐字节相同
+            settings.prettyPrint = true;
+            auto pretty = V2rayConfigGenerator::generate(server, settings);
+            Assert::IsTrue(pretty.has_value());
+            Assert::AreEqual(nlohmann::json::parse(compact).dump(2), *pretty);
+
+            // 字符串转义与 nlohmann 一致，非法 UTF-8 替换为 U+FFFD
+            const std::string text = "q\"b\\s\n\t\x01 \xE4\xB8\xAD";
+            std::string escaped;
+            JsonWriter(escaped).string(text);
+            Assert::AreEqual(nlohmann::json(text).dump(), escaped);
+            escaped.clear();
+            JsonWriter(escaped).string("a\xFF" "b");
+            Assert::AreEqual(std::string("\"a\xEF\xBF\xBD" "b\""), escaped);
+        }
+
+        TEST_METHOD(TestGenerateBatch){
+            using namespace V2rayConfigWin;
+            std::vector<ServerConfig> servers;
+            for (int i = 0; i < 40; ++i) {
+                servers.push_back(*AngConfigManager::importConfig("vless://0b65bf1e@cdn.example.com:" + std::to_string(1000 + i) + "?security=tls&sni=cdn.example.com&alpn=h2,http/1.1&type=ws#n"));
+                servers.push_back(*AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:" + std::to_string(2000 + i) + "#ss"));
+            }
+            servers.push_back(ServerConfig::create(EConfigType::CUSTOM));
+
+            // 共享前后缀拼接的结果与逐个 generate 完全相同
+            V2rayGeneratorSettings settings;
+            settings.routingMode = ERoutingMode::BYPASS_MAINLAND;
+            settings.fakeDnsEnabled = true;
+            auto configs = V2rayConfigGenerator::generate_batch(servers, settings, 4);
+            Assert::AreEqual(servers.size(), configs.size());
+            for (size_t i = 0; i < servers.size(); ++i) {
+                auto single = V2rayConfigGenerator::generate(servers[i], settings);
+                Assert::IsTrue(single.has_value() && configs[i].has_value());
+                Assert::AreEqual(*single, *configs[i]);
+            }
+        }
+
+        TEST_METHOD(TestObservatoryConfig){
+            using namespace V2rayConfigWin;
+            using json = nlohmann::json;
+            std::vector<ServerConfig> servers;
+            servers.push_back(*AngConfigManager::importConfig("vless://0b65bf1e@cdn.example.com:443?security=tls&sni=cdn.example.com&type=ws#a"));
+            servers.push_back(ServerConfig::create(EConfigType::CUSTOM));
+            servers.push_back(*AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8388#b"));
+
+            // 每台服务器一个本地 socks 端口，直接路由到对应的出站；自定义配置被跳过
+            V2rayGeneratorSettings settings;
+            settings.routingMode = ERoutingMode::BYPASS_LAN_MAINLAND;
+            V2rayConfigGenerator::ObservatoryOptions options;
+            options.basePort = 30000;
+            auto result = V2rayConfigGenerator::generate_observatory(servers, settings, options);
+            Assert::IsTrue(result.has_value());
+            Assert::AreEqual(std::string("proxy-0"), result->outboundTags[0]);
+            Assert::IsTrue(result->outboundTags[1].empty());
+            Assert::AreEqual(30002, result->ports[2]);
+            auto config = json::parse(result->config);
+            Assert::AreEqual(size_t(2), config["inbounds"].size());
+            Assert::AreEqual(30000, config["inbounds"][0]["port"].get<int>());
+            Assert::AreEqual(size_t(4), config["outbounds"].size());
+            Assert::AreEqual(std::string("proxy-2"), config["outbounds"][1]["tag"].get<std::string>());
+            Assert::AreEqual(size_t(2), config["routing"]["rules"].size());
+            Assert::AreEqual(std::string("socks-2"), config["routing"]["rules"][1]["inboundTag"][0].get<std::string>());
+            Assert::AreEqual(std::string("proxy-2"), config["routing"]["rules"][1]["outboundTag"].get<std::string>());
+            Assert::AreEqual(std::string("proxy-"), config["observatory"]["subjectSelector"][0].get<std::string>());
+            Assert::IsFalse(config["routing"].contains("balancers"));
+
+            // 负载均衡模式：原有入站和分流规则保留，代理规则改指向 leastPing 均衡器
+            options.routing = V2rayConfigGenerator::EObservatoryRouting::BALANCER;
+            result = V2rayConfigGenerator::generate_observatory(servers, settings, options);
+            Assert::IsTrue(result.has_value());
+            config = json::parse(result->config);
+            Assert::AreEqual(std::string("balancer"), config["routing"]["balancers"][0]["tag"].get<std::string>());
+            Assert::AreEqual(std::string("leastPing"), config["routing"]["balancers"][0]["strategy"]["type"].get<std::string>());
+            Assert::AreEqual(std::string("balancer"), config["routing"]["rules"][0]["balancerTag"].get<std::string>());
+            Assert::IsTrue(config["routing"]["rules"][0]["outboundTag"].is_null());
+            Assert::AreEqual(std::string("balancer"), config["routing"]["rules"].back()["balancerTag"].get<std::string>());
+            Assert::AreEqual(size_t(2), config["routing"]["rules"].back()["inboundTag"].size());
+
+            // 单服务器配置不受影响，端口越界时失败
+            Assert::IsFalse(json::parse(*V2rayConfigGenerator::generate(servers[0], settings))["routing"].contains("balancers"));
+            options.routing = V2rayConfigGenerator::EObservatoryRouting::PER_INBOUND_PORT;
+            options.basePort = 65534;
+            Assert::IsFalse(V2rayConfigGenerator::generate_observatory(servers, settings, options).has_value());
+        }
+
+        TEST_METHOD(TestRoutingRuleCompiler){
+            using namespace V2rayConfigWin;
+            // 去重、统一大小写，被 domain: 覆盖的子域名和 full: 条目去掉，CIDR 合并
+            auto compiled = RoutingRules::compile(
+                " domain:Example.com, full:www.example.com, domain:cdn.example.com, keyword ,regexp:A.*, geosite:CN, geosite:cn,,"
+                "geoip:cn, 10.1.2.3/8, 10.0.0.0/9, 192.168.0.0/25, 192.168.0.128/25, 1.2.3.4, 1.2.3.4/32, 2001:db8::/33, 2001:db8:8000::/33, geoip:cn");
+            std::vector<std::string> domains = { "domain:example.com", "keyword", "regexp:A.*", "geosite:cn" };
+            std::vector<std::string> ips = { "geoip:cn", "1.2.3.4", "10.0.0.0/8", "192.168.0.0/24", "2001:db8::/32" };
+            Assert::IsTrue(compiled.domains == domains);
+            Assert::IsTrue(compiled.ips == ips);
+
+            // 相同文本命中缓存，返回同一份结果
+            auto first = RoutingRules::compile_cached("geoip:private, 8.8.8.8");
+            Assert::IsTrue(first == RoutingRules::compile_cached("geoip:private, 8.8.8.8"));
+            Assert::IsFalse(first == RoutingRules::compile_cached("geoip:private, 8.8.4.4"));
+
+            // generate 只输出合并后的规则
+            V2rayGeneratorSettings settings;
+            settings.userRoutingDirect = "192.168.1.0/24, 192.168.0.0/24, 192.168.1.7";
+            auto config = nlohmann::json::parse(*V2rayConfigGenerator::generate(*AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8388#b"), settings));
+            const auto& userRule = config["routing"]["rules"].back();
+            Assert::AreEqual(size_t(1), userRule["ip"].size());
+            Assert::AreEqual(std::string("192.168.0.0/23"), userRule["ip"][0].get<std::string>());
+        }
+
+        TEST_METHOD(TestConfigCache){
+            using namespace V2rayConfigWin;
+            auto a = *AngConfigManager::importConfig("vless://0b65bf1e@cdn.example.com:443?security=tls&sni=cdn.example.com&type=ws#a");
+            auto b = *AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8388#b");
+            auto c = *AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8389#c");
+            V2rayGeneratorSettings settings;
+
+            // 命中时返回与 generate 相同的配置；备注不影响键，设置变化则不命中
+            ConfigCache cache(2);
+            Assert::AreEqual(*V2rayConfigGenerator::generate(a, settings), *cache.generate(a, settings));
+            auto renamed = a;
+            renamed.remarks = "renamed";
+            Assert::AreEqual(*V2rayConfigGenerator::generate(a, settings), *cache.generate(renamed, settings));
+            Assert::AreEqual(size_t(1), cache.hits());
+            auto other = settings;
+            other.routingMode = ERoutingMode::BYPASS_LAN;
+            Assert::IsFalse(*ConfigCache::key(a, settings) == *ConfigCache::key(a, other));
+            Assert::IsFalse(ConfigCache::key(ServerConfig::create(EConfigType::CUSTOM), settings).has_value());
+
+            // 容量满时淘汰最久未用的条目
+            cache.generate(b, settings);
+            cache.generate(a, settings);
+            cache.generate(c, settings);
+            Assert::AreEqual(size_t(2), cache.size());
+            Assert::IsTrue(cache.lookup(*ConfigCache::key(a, settings)).has_value());
+            Assert::IsFalse(cache.lookup(*ConfigCache::key(b, settings)).has_value());
+
+            // 持久化后重新加载，顺序与内容保持不变；损坏的文件被丢弃
+            const auto path = std::filesystem::temp_directory_path() / "react_local_storage_config_cache.bin";
+            Assert::IsTrue(static_cast<bool>(cache.save(path)));
+            ConfigCache loaded(2);
+            Assert::IsTrue(static_cast<bool>(loaded.load(path)));
+            Assert::AreEqual(*V2rayConfigGenerator::generate(c, settings), *loaded.lookup(*ConfigCache::key(c, settings)));
+            Assert::IsTrue(loaded.lookup(*ConfigCache::key(a, settings)).has_value());
+            Assert::IsFalse(loaded.dirty());
+
+            std::string bytes;
+            {
+                std::ifstream in(path, std::ios::binary);
+                bytes.assign(std::istreambuf_iterator<char>(in), {});
+            }
+            bytes.back() ^= 0x55;
+            {
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            }
+            Assert::IsTrue(loaded.load(path).status == CacheFileStatus::ChecksumMismatch);
+            Assert::AreEqual(size_t(0), loaded.size());
+            std::filesystem::remove(path);
+            Assert::IsTrue(loaded.load(path).status == CacheFileStatus::Missing);
+        }
+
+        TEST_METHOD(TestIncrementalGenerate){
+            using namespace V2rayConfigWin;
+            namespace detail = V2rayConfigGenerator::detail;
+            auto server = *AngConfigManager::importConfig("vless://0b65bf1e@cdn.example.com:443?security=tls&sni=cdn.example.com&type=ws#a");
+            V2rayGeneratorSettings settings;
+            V2rayConfigGenerator::IncrementalGenerator generator;
+            Assert::IsFalse(generator.update(settings).has_value());
+            Assert::AreEqual(*V2rayConfigGenerator::generate(server, settings), *generator.generate(server, settings));
+            Assert::AreEqual(detail::kAllStages, generator.lastStages());
+
+            // 只重跑受影响的阶段，结果与完整生成一致
+            settings.routingMode = ERoutingMode::BYPASS_LAN_MAINLAND;
+            Assert::AreEqual(*V2rayConfigGenerator::generate(server, settings), *generator.update(settings));
+            Assert::AreEqual(detail::kStageRouting | detail::kStageDns, generator.lastStages());
+
+            settings.fakeDnsEnabled = true;
+            Assert::AreEqual(*V2rayConfigGenerator::generate(server, settings), *generator.generate(server, settings));
+            Assert::AreEqual(detail::kStageInbounds | detail::kStageOutbounds | detail::kStageDns, generator.lastStages());
+
+            // 开关来回切换后不残留旧状态
+            settings.fakeDnsEnabled = false;
+            settings.socksPort = 20000;
+            settings.speedEnabled = false;
+            Assert::AreEqual(*V2rayConfigGenerator::generate(server, settings), *generator.update(settings));
+            Assert::AreEqual(detail::kStageInbounds | detail::kStageOutbounds | detail::kStageStats | detail::kStageDns, generator.lastStages());
+
+            settings.prettyPrint = true;
+            Assert::AreEqual(*V2rayConfigGenerator::generate(server, settings), *generator.update(settings));
+            Assert::AreEqual(0u, generator.lastStages());
+
+            // 换服务器时完整生成
+            auto other = *AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8388#b");
+            Assert::AreEqual(*V2rayConfigGenerator::generate(other, settings), *generator.generate(other, settings));
+            Assert::AreEqual(detail::kAllStages, generator.lastStages());
+        }
+
+        TEST_METHOD(TestDnsSection){
+            using namespace V2rayConfigWin;
+            using json = nlohmann::json;
+            auto server = *AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8388#b");
+            V2rayGeneratorSettings settings;
+            settings.routingMode = ERoutingMode::BYPASS_LAN_MAINLAND;
+            settings.userRoutingAgent = "geosite:google, 8.8.4.4";
+            settings.userRoutingDirect = "domain:Example.cn, keyword";
+            settings.userRoutingBlocked = "geosite:category-ads";
+
+            // 缓存开启、A/AAAA 并行查询；直连域名和 geosite:cn 固定走国内 DNS 且不回退
+            auto config = json::parse(*V2rayConfigGenerator::generate(server, settings));
+            const auto& dns = config["dns"];
+            Assert::AreEqual(std::string("UseIP"), dns["queryStrategy"].get<std::string>());
+            Assert::IsFalse(dns["disableCache"].get<bool>());
+            Assert::IsTrue(dns["disableFallbackIfMatch"].get<bool>());
+            Assert::AreEqual(std::string("1.1.1.1"), dns["servers"][0].get<std::string>());
+            Assert::AreEqual(std::string("geosite:google"), dns["servers"][2]["domains"][0].get<std::string>());
+            Assert::AreEqual(std::string("223.5.5.5"), dns["servers"][3]["address"].get<std::string>());
+            Assert::AreEqual(std::string("domain:example.cn"), dns["servers"][3]["domains"][0].get<std::string>());
+            Assert::AreEqual(size_t(1), dns["servers"][3]["domains"].size());
+            Assert::IsTrue(dns["servers"][3]["skipFallback"].get<bool>());
+            Assert::AreEqual(std::string("geosite:cn"), dns["servers"][4]["domains"][0].get<std::string>());
+            Assert::AreEqual(std::string("127.0.0.1"), dns["hosts"]["geosite:category-ads"].get<std::string>());
+
+            // DNS 服务器自身的查询：远程走代理，国内直连
+            const auto& rules = config["routing"]["rules"];
+            Assert::AreEqual(std::string("proxy"), rules[0]["outboundTag"].get<std::string>());
+            Assert::AreEqual(std::string("53"), rules[0]["port"].get<std::string>());
+            Assert::AreEqual(std::string("direct"), rules[1]["outboundTag"].get<std::string>());
+            Assert::AreEqual(std::string("223.5.5.5"), rules[1]["ip"][0].get<std::string>());
+
+            // 本地 DNS：dns-in 入站经 dns-out 出站交给核心解析，开启 fakedns 时优先
+            settings.localDnsEnabled = true;
+            settings.localDnsPort = 5353;
+            settings.fakeDnsEnabled = true;
+            config = json::parse(*V2rayConfigGenerator::generate(server, settings));
+            Assert::AreEqual(std::string("dns-in"), config["inbounds"].back()["tag"].get<std::string>());
+            Assert::AreEqual(5353, config["inbounds"].back()["port"].get<int>());
+            Assert::AreEqual(std::string("dns-out"), config["outbounds"].back()["tag"].get<std::string>());
+            Assert::AreEqual(std::string("dns-out"), config["routing"]["rules"][0]["outboundTag"].get<std::string>());
+            Assert::AreEqual(std::string("fakedns"), config["dns"]["servers"][0]["address"].get<std::string>());
+        }
+
+        TEST_METHOD(TestGeoIndex){
+            using namespace V2rayConfigWin;
+            // 按 protobuf 格式构造 GeoIPList / GeoSiteList：每个条目只带 country_code 和一个占位字段
+            auto geo_file = [](std::initializer_list<std::string> codes) {
+                std::string out;
+                for (const auto& code : codes) {
+                    std::string entry = "\x0a" + std::string(1, static_cast<char>(code.size())) + code + "\x10\x01";
+                    out += "\x0a" + std::string(1, static_cast<char>(entry.size())) + entry;
+                }
+                return out;
+            };
+            const auto dir = std::filesystem::temp_directory_path() / "react_local_storage_geo";
+            std::filesystem::create_directories(dir);
+            {
+                std::ofstream(dir / "geoip.dat", std::ios::binary) << geo_file({ "CN", "private" });
+                std::ofstream(dir / "geosite.dat", std::ios::binary) << geo_file({ "cn", "google", "category-ads-all" });
+            }
+
+            GeoIndex index;
+            Assert::IsTrue(index.open(dir));
+            Assert::AreEqual(size_t(2), index.geoipCount());
+            Assert::AreEqual(size_t(3), index.geositeCount());
+            Assert::IsTrue(index.hasGeoip("cn"));
+            Assert::IsTrue(index.hasGeosite("Google"));
+            Assert::IsFalse(index.hasGeosite("netflix"));
+            Assert::AreEqual(std::string("\x0a\x02" "cn\x10\x01"), index.geositeEntry("cn"));
+
+            // 前缀 "!" 与 "@属性" 不影响分类查找，非 geo 条目一律保留
+            Assert::IsTrue(RoutingRules::geo_entry_exists("geoip:!cn", index));
+            Assert::IsTrue(RoutingRules::geo_entry_exists("geosite:google@cn", index));
+            Assert::IsFalse(RoutingRules::geo_entry_exists("geoip:us", index));
+            Assert::IsTrue(RoutingRules::geo_entry_exists("domain:example.com", index));
+
+            // 生成时剔除未知分类，并能事先列出它们
+            V2rayGeneratorSettings settings;
+            settings.userRoutingAgent = "geosite:google,geosite:netflix,geoip:us,domain:example.com";
+            Assert::AreEqual(size_t(2), V2rayConfigGenerator::find_unknown_geo_rules(settings, index).size());
+            settings.geoCatalog = &index;
+            Assert::AreEqual(size_t(2), V2rayConfigGenerator::find_unknown_geo_rules(settings, index).size());
+            auto server = *AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8388#a");
+            const auto config = *V2rayConfigGenerator::generate(server, settings);
+            Assert::IsTrue(config.find("geosite:netflix") == std::string::npos);
+            Assert::IsTrue(config.find("geoip:us") == std::string::npos);
+            Assert::IsTrue(config.find("geosite:google") != std::string::npos);
+
+            // 建完索引后不再占用文件：可以直接替换，替换后 stale() 为真
+            Assert::IsFalse(index.stale());
+            V2rayConfigGenerator::IncrementalGenerator incremental;
+            Assert::IsTrue(incremental.generate(server, settings)->find("geosite:google") != std::string::npos);
+            const uint64_t before = index.fingerprint();
+            {
+                std::ofstream(dir / "geosite.dat", std::ios::binary | std::ios::trunc) << geo_file({ "cn" });
+            }
+            Assert::IsTrue(index.stale());
+            Assert::IsTrue(index.geositeEntry("cn").empty());
+            // 原地重新加载后指纹改变，增量生成据此重新裁剪规则
+            Assert::IsTrue(index.openGeosite(dir / "geosite.dat"));
+            Assert::IsFalse(index.stale());
+            Assert::IsTrue(before != index.fingerprint());
+            Assert::IsTrue(incremental.update(settings)->find("geosite:google") == std::string::npos);
+            Assert::IsTrue(std::filesystem::remove(dir / "geoip.dat"));
+            Assert::IsTrue(index.stale());
+            Assert::IsTrue(index.hasGeoip("cn"));
+
+            // 缺失或损坏的文件不加载，此时接受所有分类
+            GeoIndex missing;
+            Assert::IsFalse(missing.open(dir / "absent"));
+            Assert::IsTrue(missing.hasGeosite("netflix"));
+            {
+                std::ofstream(dir / "geosite.dat", std::ios::binary | std::ios::trunc) << std::string("\x0a\x7f", 2);
+            }
+            Assert::IsFalse(index.openGeosite(dir / "geosite.dat"));
+            Assert::IsTrue(index.hasGeosite("netflix"));
+            std::filesystem::remove_all(dir);
+        }
+
+        TEST_METHOD(TestRoutingModeRules){
+            using namespace V2rayConfigWin;
+            auto server = *AngConfigManager::importConfig("ss://YWVzLTI1Ni1nY206cEBzczp3b3Jk@198.51.100.7:8388#a");
+            V2rayGeneratorSettings settings;
+            settings.userRoutingDirect = "domain:example.com";
+            auto rules_of = [&](ERoutingMode mode) {
+                settings.routingMode = mode;
+                return nlohmann::json::parse(*V2rayConfigGenerator::generate(server, settings))["routing"]["rules"];
+            };
+
+            // 分流模式的规则块预先构建并共享：googleapis 规则排在用户规则之前，geo 规则排在其后
+            auto rules = rules_of(ERoutingMode::BYPASS_LAN_MAINLAND);
+            Assert::AreEqual(std::string("geosite:cn"), rules.back()["domain"][0].get<std::string>());
+            Assert::AreEqual(std::string("geoip:cn"), rules[rules.size() - 2]["ip"][0].get<std::string>());
+            Assert::AreEqual(std::string("geoip:private"), rules[rules.size() - 3]["ip"][0].get<std::string>());
+            Assert::AreEqual(std::string("domain:example.com"), rules[rules.size() - 4]["domain"][0].get<std::string>());
+            Assert::AreEqual(std::string("domain:googleapis.cn"), rules[rules.size() - 5]["domain"][0].get<std::string>());
+            Assert::IsTrue(rules == rules_of(ERoutingMode::BYPASS_LAN_MAINLAND));
+            Assert::AreEqual(std::string("0-65535"), rules_of(ERoutingMode::GLOBAL_DIRECT).back()["port"].get<std::string>());
+            Assert::AreEqual(std::string("domain:example.com"), rules_of(ERoutingMode::GLOBAL_PROXY).back()["domain"][0].get<std::string>());
+
+            // 带 geo 目录时，共享块中缺失分类的规则被跳过，共享块本身不变
+            struct NoCn : RoutingRules::GeoCatalog {
+                bool hasGeoip(std::string_view code) const override { return code != "cn"; }
+                bool hasGeosite(std::string_view code) const override { return code != "cn"; }
+                uint64_t fingerprint() const override { return 1; }
+            } catalog;
+            settings.geoCatalog = &catalog;
+            auto pruned = rules_of(ERoutingMode::BYPASS_LAN_MAINLAND);
+            Assert::AreEqual(rules.size() - 2, pruned.size());
+            Assert::AreEqual(std::string("geoip:private"), pruned.back()["ip"][0].get<std::string>());
+            settings.geoCatalog = nullptr;
+            Assert::IsTrue(rules == rules_of(ERoutingMode::BYPASS_LAN_MAINLAND));
+        }
+
+        TEST_METHOD(TestParseErrors){
+            using namespace V2rayConfigWin::AngConfigManager;
+            // 解析失败时返回错误码和出错位置，不抛异常
+            V2rayConfigWin::ServerConfig config;
+            auto port = parseConfig("vless://id@host:99999", config);
+            Assert::IsTrue(port.status == ImportStatus::InvalidPort);
+            Assert::AreEqual(size_t(16), port.offset);
+
+            auto base64 = parseConfig("vmess://ab*c", config);
+            Assert::IsTrue(base64.status == ImportStatus::InvalidBase64);
+            Assert::AreEqual(size_t(10), base64.offset);
+
+            // {"add":"a",
+            Assert::IsTrue(parseConfig("vmess://eyJhZGQiOiJhIiw=", config).status == ImportStatus::InvalidJson);
+            Assert::IsTrue(parseConfig("trojan://secret@example.com:443", config).status == ImportStatus::UnsupportedProtocol);
+
+            // {"add":"a","port":443,"id":"x","net":"tcp"}：端口为数字
+            Assert::IsTrue(static_cast<bool>(parseConfig("vmess://eyJhZGQiOiJhIiwicG9ydCI6NDQzLCJpZCI6IngiLCJuZXQiOiJ0Y3AifQ==", config)));
+            Assert::AreEqual(443, config.outboundBean->settings->vnext->at(0).port);
+        }
+
+        TEST_METHOD(TestVmessFieldExtraction){
+            // 仅提取需要的字段，跳过嵌套值，处理转义
+            const std::string payload = R"({"v":"2","ps":"\u9999\u6e2f \"01\"","add":"a.example.com","port":443,"extra":{"k":[1,2,{"x":null}]},"id":"uuid","net":"ws","path":"\/ray","tls":null})";
+            V2rayConfigWin::VmessQRCode code;
+            Assert::IsFalse(V2rayConfigWin::extract_vmess_fields(payload, code).has_value());
+            Assert::AreEqual(std::string("\xE9\xA6\x99\xE6\xB8\xAF \"01\""), code.ps);
+            Assert::AreEqual(std::string("443"), code.port);
+            Assert::AreEqual(std::string("/ray"), code.path);
+            Assert::AreEqual(std::string(""), code.tls);
+            Assert::AreEqual(std::string("auto"), code.scy);
+
+            auto error = V2rayConfigWin::extract_vmess_fields(R"({"ps":"x",,"add":"y"})", code);
+            Assert::IsTrue(error.has_value());
+            Assert::AreEqual(size_t(10), *error);
+        }
+
+        TEST_METHOD(TestIpClassification){
+            using namespace V2rayConfigWin::Utils;
+            Assert::IsTrue(is_ip_address("8.8.8.8"));
+            Assert::IsTrue(is_ip_address("10.0.0.0/8"));
+            Assert::IsTrue(is_ip_address("2001:db8::1"));
+            Assert::IsTrue(is_ip_address("[::ffff:192.168.1.1]"));
+            Assert::IsTrue(is_ip_address("fc00::/7"));
+            Assert::IsFalse(is_ip_address("256.1.1.1"));
+            Assert::IsFalse(is_ip_address("10.0.0.0/33"));
+            Assert::IsFalse(is_ip_address("1::2::3"));
+            Assert::IsFalse(is_ip_address("domain:example.com"));
+            Assert::IsTrue(is_pure_ip_address("192.168.1.1"));
+            Assert::IsFalse(is_pure_ip_address("192.168.1.1/24"));
+            Assert::IsTrue(is_cidr("192.168.0.0/16"));
+            Assert::IsFalse(is_cidr("192.168.0.1"));
+
+            auto v6 = parse_ipv6("2001:db8::8:800:200c:417a");
+            Assert::IsTrue(v6.has_value());
+            Assert::AreEqual(0x20, static_cast<int>((*v6)[0]));
+            Assert::AreEqual(0x00, static_cast<int>((*v6)[4]));
+            Assert::AreEqual(0x7a, static_cast<int>((*v6)[15]));
+
+            Assert::AreEqual(std::string("geoip:cn"), std::string(trim(" \tgeoip:cn\r\n")));
+        }
+    };
+
+    TEST_CLASS(StorageCoreTests)
+    {
+        using StorageCore = winrt::ReactLocalStorage::StorageCore;
+
+        // 每个测试使用独立的数据库文件，结束时连同 WAL 文件一起删除
+        static std::string TempDbPath(const char* name) {
+            const auto path = std::filesystem::temp_directory_path() / (std::string("react_local_storage_") + name + ".db");
+            RemoveDb(path.string());
+            return path.string();
+        }
+
+        static void RemoveDb(std::string const& path) {
+            std::error_code ec;
+            for (const char* suffix : { "", "-wal", "-shm" }) std::filesystem::remove(path + suffix, ec);
+        }
+
+        static void WriteFile(std::string const& path, std::string const& text) {
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << text;
+        }
+
+        // 包装默认 VFS 并注册为默认：置位 busyWalWrites 后写 WAL 文件返回 SQLITE_BUSY，
+        // 这样 COMMIT 失败后事务仍然保持打开（与被其他进程占用文件时相同）
+        struct BusyWalVfs {
+            struct File {
+                sqlite3_file base;
+                bool wal;
+                sqlite3_file* Real() { return reinterpret_cast<sqlite3_file*>(this + 1); }
+            };
+
+            static inline std::atomic<bool> busyWalWrites{ false };
+            static inline sqlite3_vfs* real = nullptr;
+            static inline sqlite3_vfs vfs{};
+            static inline sqlite3_io_methods methods{};
+
+            static sqlite3_file* R(sqlite3_file* file) { return reinterpret_cast<File*>(file)->Real(); }
+
+            static void Register() {
+                real = sqlite3_vfs_find(nullptr);
+                vfs = *real;
+                vfs.zName = "busy_wal";
+                vfs.szOsFile = static_cast<int>(sizeof(File)) + real->szOsFile;
+                vfs.xOpen = [](sqlite3_vfs*, const char* name, sqlite3_file* file, int flags, int* outFlags) {
+                    auto* wrapped = reinterpret_cast<File*>(file);
+                    wrapped->wal = (flags & SQLITE_OPEN_WAL) != 0;
+                    int rc = real->xOpen(real, name, wrapped->Real(), flags, outFlags);
+                    wrapped->base.pMethods = rc == SQLITE_OK ? &methods : nullptr;
+                    return rc;
+                };
+                methods.iVersion = 3;
+                methods.xClose = [](sqlite3_file* f) { return R(f)->pMethods->xClose(R(f)); };
+                methods.xRead = [](sqlite3_file* f, void* buffer, int amount, sqlite3_int64 offset) { return R(f)->pMethods->xRead(R(f), buffer, amount, offset); };
+                methods.xWrite = [](sqlite3_file* f, const void* buffer, int amount, sqlite3_int64 offset) {
+                    if (reinterpret_cast<File*>(f)->wal && busyWalWrites) return SQLITE_BUSY;
+                    return R(f)->pMethods->xWrite(R(f), buffer, amount, offset);
+                };
+                methods.xTruncate = [](sqlite3_file* f, sqlite3_int64 size) { return R(f)->pMethods->xTruncate(R(f), size); };
+                methods.xSync = [](sqlite3_file* f, int flags) { return R(f)->pMethods->xSync(R(f), flags); };
+                methods.xFileSize = [](sqlite3_file* f, sqlite3_int64* size) { return R(f)->pMethods->xFileSize(R(f), size); };
+                methods.xLock = [](sqlite3_file* f, int lock) { return R(f)->pMethods->xLock(R(f), lock); };
+                methods.xUnlock = [](sqlite3_file* f, int lock) { return R(f)->pMethods->xUnlock(R(f), lock); };
+                methods.xCheckReservedLock = [](sqlite3_file* f, int* out) { return R(f)->pMethods->xCheckReservedLock(R(f), out); };
+                methods.xFileControl = [](sqlite3_file* f, int op, void* arg) { return R(f)->pMethods->xFileControl(R(f), op, arg); };
+                methods.xSectorSize = [](sqlite3_file* f) { return R(f)->pMethods->xSectorSize(R(f)); };
+                methods.xDeviceCharacteristics = [](sqlite3_file* f) { return R(f)->pMethods->xDeviceCharacteristics(R(f)); };
+                methods.xShmMap = [](sqlite3_file* f, int region, int size, int extend, void volatile** out) { return R(f)->pMethods->xShmMap(R(f), region, size, extend, out); };
+                methods.xShmLock = [](sqlite3_file* f, int offset, int n, int flags) { return R(f)->pMethods->xShmLock(R(f), offset, n, flags); };
+                methods.xShmBarrier = [](sqlite3_file* f) { R(f)->pMethods->xShmBarrier(R(f)); };
+                methods.xShmUnmap = [](sqlite3_file* f, int deleteFlag) { return R(f)->pMethods->xShmUnmap(R(f), deleteFlag); };
+                methods.xFetch = [](sqlite3_file* f, sqlite3_int64 offset, int amount, void** out) { return R(f)->pMethods->xFetch(R(f), offset, amount, out); };
+                methods.xUnfetch = [](sqlite3_file* f, sqlite3_int64 offset, void* page) { return R(f)->pMethods->xUnfetch(R(f), offset, page); };
+                sqlite3_vfs_register(&vfs, 1);
+            }
+
+            static void Unregister() {
+                sqlite3_vfs_unregister(&vfs);
+            }
+        };
+
+    public:
+        TEST_METHOD(TestAcquireOpenFailure){
+            // 打开失败时返回 nullptr，不能在持有注册表锁时死锁
+            const auto path = (std::filesystem::temp_directory_path() / "react_local_storage_missing_dir" / "x.db").string();
+            Assert::IsTrue(StorageCore::Acquire(path) == nullptr);
+            Assert::IsTrue(StorageCore::Acquire(path) == nullptr);
+            Assert::IsTrue(StorageCore::Acquire("") == nullptr);
+        }
+
+        TEST_METHOD(TestAcquireSharesCore){
+            const auto path = TempDbPath("shared");
+            {
+                auto first = StorageCore::Acquire(path);
+                auto second = StorageCore::Acquire(path);
+                Assert::IsTrue(first != nullptr);
+                Assert::IsTrue(first == second);
+
+                // 一个实例写入，另一个实例立即可见
+                first->SetItem("k", "v");
+                Assert::AreEqual(std::string("v"), *second->GetItem("k"));
+            }
+            // 最后一个持有者释放后重新打开，数据来自磁盘
+            auto reopened = StorageCore::Acquire(path);
+            Assert::AreEqual(std::string("v"), *reopened->GetItem("k"));
+            reopened.reset();
+            RemoveDb(path);
+        }
+
+        TEST_METHOD(TestReadAfterFlush){
+            const auto path = TempDbPath("flush");
+            auto core = StorageCore::Acquire(path);
+            core->SetItem("a", "1");
+            core->SetItem("a", "2");
+            core->SetItem("b", "3");
+            core->RemoveItem("b");
+            core->Flush();
+
+            // 清空缓存后经读连接读取，验证写线程已提交
+            core->TrimMemory(0);
+            Assert::AreEqual(size_t(0), core->MemoryUsage());
+            Assert::AreEqual(std::string("2"), *core->GetItem("a"));
+            Assert::IsFalse(core->GetItem("b").has_value());
+            core.reset();
+            RemoveDb(path);
+        }
+
+        TEST_METHOD(TestFailedWriteIsNotCached){
+            const auto path = TempDbPath("failed_write");
+            auto core = StorageCore::Acquire(path);
+            core->SetItem("good", "old");
+            core->Flush();
+
+            // 另一个连接安装触发器，让写线程提交时拒绝某个键
+            sqlite3* db = nullptr;
+            Assert::AreEqual(SQLITE_OK, sqlite3_open(path.c_str(), &db));
+            Assert::AreEqual(SQLITE_OK, sqlite3_exec(db,
+                "CREATE TRIGGER reject_bad BEFORE INSERT ON key_value_store WHEN new.item_key = 'bad' "
+                "BEGIN SELECT RAISE(ABORT, 'rejected'); END;", nullptr, nullptr, nullptr));
+            sqlite3_close(db);
+
+            // 同一批中的其他写入照常提交；失败的写入不再留在缓存里
+            core->SetItem("bad", "x");
+            core->SetItem("good", "new");
+            core->Flush();
+            Assert::IsFalse(core->GetItem("bad").has_value());
+            Assert::AreEqual(std::string("new"), *core->GetItem("good"));
+            core->TrimMemory(0);
+            Assert::AreEqual(std::string("new"), *core->GetItem("good"));
+            core.reset();
+            RemoveDb(path);
+        }
+
+        TEST_METHOD(TestMemoryPressure){
+            using winrt::ReactLocalStorage::MemoryGovernor;
+            using winrt::ReactLocalStorage::MemoryPressure;
+            auto& governor = MemoryGovernor::Instance();
+            const auto firstPath = TempDbPath("pressure_a");
+            const auto secondPath = TempDbPath("pressure_b");
+            auto first = StorageCore::Acquire(firstPath);
+            auto second = StorageCore::Acquire(secondPath);
+            // 每个缓存约 1.8MB：低于 Moderate 下单个缓存 2MB 的预算，但两者之和超过它
+            for (int i = 0; i < 1700; ++i) {
+                first->SetItem("k" + std::to_string(i), std::string(1000, 'x'));
+                second->SetItem("k" + std::to_string(i), std::string(1000, 'y'));
+            }
+            first->Flush();
+            second->Flush();
+
+            // 占用与预算都按所有缓存合计，正常状态下不会显示为超出预算
+            governor.SetPressure(MemoryPressure::Moderate);
+            auto footprint = governor.CurrentFootprint();
+            Assert::IsTrue(footprint.pressure == MemoryPressure::Moderate);
+            Assert::IsTrue(footprint.cacheBytes > governor.CacheBudgetBytes());
+            Assert::IsTrue(footprint.cacheBytes <= footprint.cacheBudgetBytes);
+            Assert::AreEqual(2 * governor.CacheBudgetBytes(), footprint.cacheBudgetBytes);
+
+            // 升到 Critical 时立即裁剪到 0，数据仍可从数据库读回
+            governor.SetPressure(MemoryPressure::Critical);
+            Assert::AreEqual(size_t(0), governor.CacheBudgetBytes());
+            Assert::AreEqual(size_t(0), first->MemoryUsage());
+            Assert::AreEqual(size_t(0), second->MemoryUsage());
+            Assert::AreEqual(std::string(1000, 'x'), *first->GetItem("k1"));
+            Assert::AreEqual(size_t(0), first->MemoryUsage());
+
+            // 回到 Normal 后缓存按需重新增长
+            governor.SetPressure(MemoryPressure::Normal);
+            Assert::IsTrue(governor.CacheBudgetBytes() > 0);
+            Assert::AreEqual(std::string(1000, 'y'), *second->GetItem("k1"));
+            Assert::IsTrue(second->MemoryUsage() > 0);
+            first.reset();
+            second.reset();
+            RemoveDb(firstPath);
+            RemoveDb(secondPath);
+        }
+
+        TEST_METHOD(TestIncrementInt64){
+            const auto path = TempDbPath("increment");
+            auto core = StorageCore::Acquire(path);
+            Assert::AreEqual(int64_t(5), *core->IncrementInt64("n", 5));
+            Assert::AreEqual(int64_t(2), *core->IncrementInt64("n", -3));
+
+            // 溢出时报错而不是回绕，原值保持不变
+            core->SetNumber("max", INT64_MAX);
+            Assert::IsFalse(core->IncrementInt64("max", 1).has_value());
+            Assert::AreEqual(int64_t(INT64_MAX), std::get<int64_t>(*core->GetNumber("max")));
+            core->SetNumber("min", INT64_MIN);
+            Assert::IsFalse(core->IncrementInt64("min", -1).has_value());
+            Assert::AreEqual(int64_t(INT64_MIN + 1), *core->IncrementInt64("min", 1));
+
+            // 小数或超出范围的 REAL 不是计数器；整数值的 REAL 可以
+            core->SetNumber("half", 1.5);
+            Assert::IsFalse(core->IncrementInt64("half", 1).has_value());
+            Assert::AreEqual(1.5, std::get<double>(*core->GetNumber("half")));
+            core->SetNumber("huge", 1e19);
+            Assert::IsFalse(core->IncrementInt64("huge", 1).has_value());
+            core->SetNumber("whole", 5.0);
+            Assert::AreEqual(int64_t(6), *core->IncrementInt64("whole", 1));
+
+            // 未缓存时从数据库读取后再递增
+            core->Flush();
+            core->TrimMemory(0);
+            Assert::AreEqual(int64_t(7), *core->IncrementInt64("whole", 1));
+            Assert::IsFalse(core->IncrementInt64("half", 1).has_value());
+
+            Assert::IsFalse(StorageCore::ExactInt64(0.5).has_value());
+            Assert::IsFalse(StorageCore::ExactInt64(9223372036854775808.0).has_value());
+            Assert::IsFalse(StorageCore::ExactInt64(std::numeric_limits<double>::quiet_NaN()).has_value());
+            Assert::AreEqual(int64_t(INT64_MIN), *StorageCore::ExactInt64(-9223372036854775808.0));
+            core.reset();
+            RemoveDb(path);
+        }
+
+        TEST_METHOD(TestSearchIndex){
+            const auto path = TempDbPath("search");
+            auto core = StorageCore::Acquire(path);
+            auto search = [&](std::string prefix, std::string query) {
+                std::promise<std::vector<std::string>> found;
+                core->Search(std::move(prefix), std::move(query), 10, [&](std::vector<std::string> keys) { found.set_value(std::move(keys)); });
+                return found.get_future().get();
+            };
+
+            core->EnableSearchIndex("note:");
+            core->SetItem("note:1", "hello world");
+            core->SetItem("note:2", "goodbye");
+            core->SetItem("other", "hello");
+
+            // 未启用的前缀（包括与已启用前缀重叠的）禁用时不应改动索引
+            core->DisableSearchIndex("oth");
+            core->DisableSearchIndex("no");
+            core->Flush();
+            sqlite3* db = nullptr;
+            Assert::AreEqual(SQLITE_OK, sqlite3_open(path.c_str(), &db));
+            Assert::AreEqual(SQLITE_OK, sqlite3_exec(db, "INSERT INTO key_value_fts(key_value_fts) VALUES('integrity-check');", nullptr, nullptr, nullptr));
+            sqlite3_close(db);
+
+            // 搜索排在之前的写入之后执行，无需调用方先 Flush
+            core->SetItem("note:3", "hello again");
+            auto keys = search("note:", "hel");
+            std::sort(keys.begin(), keys.end());
+            Assert::AreEqual(size_t(2), keys.size());
+            Assert::AreEqual(std::string("note:1"), keys[0]);
+            Assert::AreEqual(std::string("note:3"), keys[1]);
+            Assert::IsTrue(search("note:", "").empty());
+
+            core->DisableSearchIndex("note:");
+            Assert::IsTrue(search("note:", "hello").empty());
+            core.reset();
+            RemoveDb(path);
+        }
+
+        TEST_METHOD(TestImportJsonDump){
+            const auto path = TempDbPath("import");
+            const auto dump = path + ".json";
+            WriteFile(dump, R"({"a": "1", "n": 2, "o": {"x": true}, "nil": null})");
+            auto core = StorageCore::Acquire(path);
+            core->SetItem("a", "old");
+            core->GetItem("n");
+
+            // 非字符串值按 JSON 文本保存，null 跳过；导入覆盖缓存中的旧值
+            std::promise<std::pair<bool, uint64_t>> done;
+            core->ImportJsonDump(dump, nullptr, [&](bool ok, uint64_t imported, std::string const&) { done.set_value({ ok, imported }); });
+            const auto result = done.get_future().get();
+            Assert::IsTrue(result.first);
+            Assert::AreEqual(uint64_t(3), result.second);
+            Assert::AreEqual(std::string("1"), *core->GetItem("a"));
+            Assert::AreEqual(std::string("2"), *core->GetItem("n"));
+            Assert::AreEqual(std::string("{\"x\":true}"), *core->GetItem("o"));
+            Assert::IsFalse(core->GetItem("nil").has_value());
+            core.reset();
+            std::filesystem::remove(dump);
+            RemoveDb(path);
+        }
+
+        TEST_METHOD(TestImportCommitFailure){
+            BusyWalVfs::Register();
+            const auto path = TempDbPath("import_fail");
+            const auto dump = path + ".json";
+            WriteFile(dump, R"({"a": "1", "b": "2"})");
+            auto core = StorageCore::Acquire(path);
+
+            // 最后一批提交失败：导入报告失败，写连接上不能留下打开的事务
+            BusyWalVfs::busyWalWrites = true;
+            std::promise<bool> done;
+            core->ImportJsonDump(dump, nullptr, [&](bool ok, uint64_t, std::string const&) { done.set_value(ok); });
+            Assert::IsFalse(done.get_future().get());
+            BusyWalVfs::busyWalWrites = false;
+
+            // 之后的写入照常提交，经读连接可见
+            core->SetItem("after", "x");
+            core->Flush();
+            core->TrimMemory(0);
+            Assert::AreEqual(std::string("x"), *core->GetItem("after"));
+            Assert::IsFalse(core->GetItem("a").has_value());
+            core.reset();
+            BusyWalVfs::Unregister();
+            std::filesystem::remove(dump);
+            RemoveDb(path);
+        }
     };
 }
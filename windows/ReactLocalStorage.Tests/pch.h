@@ -22,4 +22,8 @@
 #include <wincrypt.h>
 #include <bcrypt.h>
 #include "V2rayConfigWin.h"
+#include "V2rayServerTable.h"
+#include "V2rayConfigCache.h"
+#include "V2rayGeoIndex.h"
 #include "V2rayManager.h"
+#include "StorageCore.h"
@@ -0,0 +1,102 @@
+#include "pch.h"
+
+#include "MemoryGovernor.h"
+#include <winsqlite/winsqlite3.h>
+#include <algorithm>
+#include <limits>
+
+namespace winrt::ReactLocalStorage
+{
+
+namespace
+{
+struct MemoryTier
+{
+    int64_t softHeapLimit; // sqlite3_soft_heap_limit64, whole process
+    int pageCacheKiB;      // PRAGMA cache_size per connection
+    size_t cacheBudget;    // per registered cache
+};
+
+constexpr MemoryTier kTiers[] = {
+    /* Normal   */ { 32 * 1024 * 1024, 2048, 8 * 1024 * 1024 },
+    /* Moderate */ { 16 * 1024 * 1024, 512, 2 * 1024 * 1024 },
+    /* Critical */ { 4 * 1024 * 1024, 128, 0 },
+};
+
+MemoryTier const& TierFor(MemoryPressure pressure)
+{
+    return kTiers[static_cast<int>(pressure)];
+}
+} // namespace
+
+MemoryGovernor& MemoryGovernor::Instance() noexcept
+{
+    static MemoryGovernor instance;
+    return instance;
+}
+
+MemoryGovernor::MemoryGovernor() noexcept
+{
+    ApplyLimits(MemoryPressure::Normal);
+}
+
+void MemoryGovernor::ApplyLimits(MemoryPressure pressure) noexcept
+{
+    auto const& tier = TierFor(pressure);
+    sqlite3_soft_heap_limit64(tier.softHeapLimit);
+    m_pageCacheKiB.store(tier.pageCacheKiB, std::memory_order_relaxed);
+    m_cacheBudget.store(tier.cacheBudget, std::memory_order_relaxed);
+    m_pressure.store(pressure, std::memory_order_relaxed);
+}
+
+void MemoryGovernor::Register(MemoryConsumer* consumer) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_consumers.push_back(consumer);
+}
+
+void MemoryGovernor::Unregister(MemoryConsumer* consumer) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_consumers.erase(std::remove(m_consumers.begin(), m_consumers.end(), consumer), m_consumers.end());
+}
+
+void MemoryGovernor::SetPressure(MemoryPressure pressure) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    bool rising = pressure > Pressure();
+    ApplyLimits(pressure);
+    if (!rising)
+    {
+        return; // caches grow back on demand
+    }
+
+    size_t budget = CacheBudgetBytes();
+    for (auto* consumer : m_consumers)
+    {
+        consumer->TrimMemory(budget);
+    }
+    // Hand freed page cache and lookaside memory back to the heap.
+    sqlite3_release_memory((std::numeric_limits<int>::max)());
+}
+
+MemoryGovernor::Footprint MemoryGovernor::CurrentFootprint() noexcept
+{
+    Footprint footprint;
+    footprint.sqliteHeapBytes = sqlite3_memory_used();
+    footprint.sqliteHeapHighwater = sqlite3_memory_highwater(0);
+    footprint.sqliteSoftHeapLimit = sqlite3_soft_heap_limit64(-1);
+    footprint.pageCacheKiB = PageCacheKiB();
+    footprint.pressure = Pressure();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Comparable with cacheBytes: both cover all consumers.
+    footprint.cacheBudgetBytes = CacheBudgetBytes() * m_consumers.size();
+    for (auto* consumer : m_consumers)
+    {
+        footprint.cacheBytes += consumer->MemoryUsage();
+    }
+    return footprint;
+}
+
+} // namespace winrt::ReactLocalStorage
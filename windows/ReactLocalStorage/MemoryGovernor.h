@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace winrt::ReactLocalStorage
+{
+
+enum class MemoryPressure
+{
+  Normal = 0,
+  Moderate = 1,
+  Critical = 2,
+};
+
+// Anything that holds a trimmable in-memory cache registers itself with the
+// governor so it can be measured and shrunk under pressure.
+class MemoryConsumer
+{
+public:
+  virtual ~MemoryConsumer() = default;
+  virtual size_t MemoryUsage() noexcept = 0;
+  // Drop cached data until usage is at most |targetBytes| (best effort).
+  virtual void TrimMemory(size_t targetBytes) noexcept = 0;
+};
+
+// Single process-wide owner of the storage layer's memory limits. Each
+// pressure tier sets SQLite's soft heap limit, the per-connection page cache
+// size and the byte budget of every registered cache.
+class MemoryGovernor
+{
+public:
+  struct Footprint
+  {
+    int64_t sqliteHeapBytes{0};
+    int64_t sqliteHeapHighwater{0};
+    int64_t sqliteSoftHeapLimit{0};
+    int pageCacheKiB{0};
+    size_t cacheBytes{0};       // summed over every registered cache
+    size_t cacheBudgetBytes{0}; // CacheBudgetBytes() times the number of caches
+    MemoryPressure pressure{MemoryPressure::Normal};
+  };
+
+  static MemoryGovernor& Instance() noexcept;
+
+  void Register(MemoryConsumer* consumer) noexcept;
+  void Unregister(MemoryConsumer* consumer) noexcept;
+
+  // Applies the limits of |pressure|. Raising the tier trims every consumer
+  // immediately and asks SQLite to release what it can.
+  void SetPressure(MemoryPressure pressure) noexcept;
+  MemoryPressure Pressure() const noexcept { return m_pressure.load(std::memory_order_relaxed); }
+
+  // Byte budget for each registered cache under the current tier.
+  size_t CacheBudgetBytes() const noexcept { return m_cacheBudget.load(std::memory_order_relaxed); }
+  // Page cache size in KiB each SQLite connection should use.
+  int PageCacheKiB() const noexcept { return m_pageCacheKiB.load(std::memory_order_relaxed); }
+
+  Footprint CurrentFootprint() noexcept;
+
+private:
+  MemoryGovernor() noexcept;
+  void ApplyLimits(MemoryPressure pressure) noexcept;
+
+  std::mutex m_mutex;
+  std::vector<MemoryConsumer*> m_consumers;
+  std::atomic<MemoryPressure> m_pressure{MemoryPressure::Normal};
+  std::atomic<size_t> m_cacheBudget{0};
+  std::atomic<int> m_pageCacheKiB{0};
+};
+
+} // namespace winrt::ReactLocalStorage
@@ -2,7 +2,6 @@
 
 #include "ReactLocalStorage.h"
 #include "V2rayConfigWin.h"
-#include <winsqlite/winsqlite3.h>
 #include <winrt/Windows.Storage.h> // Required for ApplicationData
 #include <filesystem>              // Required for path operations (C++17)
 #include <winrt/Windows.System.Profile.h>
@@ -10,6 +9,8 @@
 #include <winrt/base.h> // 提供 winrt::to_hstring
 #include <string>
 #include <cstdint> // 提供 int32_t
+#include <algorithm>
+#include <variant>
 // Windows API
 #include <windows.h>
 #include <wincrypt.h>
@@ -77,6 +78,22 @@ std::string to_string(winrt::hstring const& hstr)
     WideCharToMultiByte(CP_UTF8, 0, hstr.c_str(), (int)hstr.size(), &strTo[0], size_needed, NULL, NULL);
     return strTo;
 }
+
+// 缓存文件读写失败只记录原因，缓存本身照常工作
+void LogCacheFileResult(const char* what, V2rayConfigWin::CacheFileResult const& result)
+{
+    if (result)
+    {
+        return;
+    }
+    std::string message = std::string(what) + " failed with status " + std::to_string(static_cast<int>(result.status));
+    if (result.error)
+    {
+        message += ": " + result.error.message();
+    }
+    OutputDebugStringA((message + "\n").c_str());
+}
+
 std::string ReactLocalStorage::GetDbPath() noexcept
 {
     try
@@ -94,52 +111,215 @@ std::string ReactLocalStorage::GetDbPath() noexcept
     }
 }
 
-void ReactLocalStorage::EnsureDbOpen() noexcept
+std::string ReactLocalStorage::GetServerCachePath() noexcept
 {
-    if (m_db)
+    std::string dbPath = GetDbPath();
+    if (dbPath.empty())
     {
-        return; // Already open
+        return {};
     }
+    return std::filesystem::path(dbPath).replace_filename("server_cache.bin").string();
+}
 
+std::string ReactLocalStorage::GetConfigCachePath() noexcept
+{
     std::string dbPath = GetDbPath();
     if (dbPath.empty())
     {
-        OutputDebugStringA("DB path is empty, cannot open database.\n");
-        return;
+        return {};
     }
+    return std::filesystem::path(dbPath).replace_filename("config_cache.bin").string();
+}
 
-    int rc = sqlite3_open_v2(dbPath.c_str(), &m_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr);
-    if (rc != SQLITE_OK)
+ReactLocalStorage::ServerCacheState::ServerCacheState() noexcept
+{
+    MemoryGovernor::Instance().Register(this);
+}
+
+ReactLocalStorage::ServerCacheState::~ServerCacheState()
+{
+    MemoryGovernor::Instance().Unregister(this);
+    // ImportLink 不逐条落盘，未保存的条目在这里一次写出
+    try
+    {
+        if (cache.dirty() && !path.empty())
+        {
+            LogCacheFileResult("Saving server cache", cache.save(path));
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        OutputDebugStringA(("Failed to save server cache: " + std::string(ex.what()) + "\n").c_str());
+    }
+}
+
+void ReactLocalStorage::ServerCacheState::EnsureLoaded(std::string const& cachePath) noexcept
+{
+    if (loaded)
     {
-        OutputDebugStringA(("Failed to open database: " + std::string(sqlite3_errmsg(m_db)) + "\n").c_str());
-        sqlite3_close(m_db); // sqlite3_close can be called on a null pointer or an unopened db
-        m_db = nullptr;
         return;
     }
+    loaded = true;
+    path = cachePath;
 
-    // Create table if it doesn't exist
-    const char* createTableSql = "CREATE TABLE IF NOT EXISTS key_value_store (item_key TEXT PRIMARY KEY NOT NULL, item_value TEXT);";
-    char* errMsg = nullptr;
-    rc = sqlite3_exec(m_db, createTableSql, nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK)
+    try
+    {
+        if (!path.empty())
+        {
+            LogCacheFileResult("Loading server cache", cache.load(path));
+        }
+    }
+    catch (std::exception const& ex)
     {
-        OutputDebugStringA(("Failed to create table: " + std::string(errMsg) + "\n").c_str());
-        sqlite3_free(errMsg);
-        CloseDb(); // Close DB if table creation fails
+        cache.clear();
+        OutputDebugStringA(("Failed to load server cache: " + std::string(ex.what()) + "\n").c_str());
     }
+    Settle();
 }
 
-void ReactLocalStorage::CloseDb() noexcept
+void ReactLocalStorage::ServerCacheState::Settle() noexcept
 {
-    if (m_db)
+    size_t target = (std::min)(pendingTrim.exchange(SIZE_MAX), MemoryGovernor::Instance().CacheBudgetBytes());
+    try
+    {
+        cache.trimToBytes(target);
+    }
+    catch (std::exception const&)
+    {
+        cache.clear(); // 重建失败时整体丢弃，缓存可以随时重新解析
+    }
+    usage.store(cache.memoryBytes(), std::memory_order_relaxed);
+}
+
+size_t ReactLocalStorage::ServerCacheState::MemoryUsage() noexcept
+{
+    // 导入期间可能长时间持锁，这里只读上次记录的用量
+    return usage.load(std::memory_order_relaxed);
+}
+
+void ReactLocalStorage::ServerCacheState::TrimMemory(size_t targetBytes) noexcept
+{
+    // 正在导入时不等锁，由持锁方结束时在 Settle() 中裁剪
+    pendingTrim.store(targetBytes);
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (lock.owns_lock())
     {
-        sqlite3_close(m_db);
-        m_db = nullptr;
+        Settle();
     }
 }
 
+std::optional<V2rayConfigWin::ServerConfig> ReactLocalStorage::ImportLink(std::string const& link) noexcept
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(m_serverCache->mutex);
+        m_serverCache->EnsureLoaded(GetServerCachePath());
+
+        V2rayConfigWin::ServerConfig config;
+        if (m_serverCache->cache.lookup(link, config))
+        {
+            return config;
+        }
+        std::optional<V2rayConfigWin::ServerConfig> result = V2rayConfigWin::AngConfigManager::importConfig(link);
+        if (result)
+        {
+            m_serverCache->cache.store(link, *result);
+            m_serverCache->Settle();
+        }
+        return result;
+    }
+    catch (std::exception const& ex)
+    {
+        OutputDebugStringA(("ImportLink failed: " + std::string(ex.what()) + "\n").c_str());
+        return std::nullopt;
+    }
+}
+
+std::optional<std::string> ReactLocalStorage::GenerateConfig(V2rayConfigWin::ServerConfig const& server,
+                                                             V2rayConfigWin::V2rayGeneratorSettings const& settings) noexcept
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(m_configCacheMutex);
+        if (!m_configCacheLoaded)
+        {
+            m_configCacheLoaded = true;
+            m_configCachePath = GetConfigCachePath();
+            if (!m_configCachePath.empty())
+            {
+                LogCacheFileResult("Loading config cache", m_configCache.load(m_configCachePath));
+            }
+        }
+
+        // 未命中时只更新内存，由 SaveConfigCache 在析构时一次写回，连接路径上不写磁盘
+        return m_configCache.generate(server, settings);
+    }
+    catch (std::exception const& ex)
+    {
+        OutputDebugStringA(("GenerateConfig failed: " + std::string(ex.what()) + "\n").c_str());
+        return std::nullopt;
+    }
+}
+
+void ReactLocalStorage::SaveConfigCache() noexcept
+{
+    try
+    {
+        std::lock_guard<std::mutex> lock(m_configCacheMutex);
+        if (m_configCache.dirty() && !m_configCachePath.empty())
+        {
+            LogCacheFileResult("Saving config cache", m_configCache.save(m_configCachePath));
+        }
+    }
+    catch (std::exception const& ex)
+    {
+        OutputDebugStringA(("Failed to save config cache: " + std::string(ex.what()) + "\n").c_str());
+    }
+}
+
+std::shared_ptr<V2rayConfigWin::GeoIndex const> ReactLocalStorage::EnsureGeoIndexLoaded(std::string const& directory) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_geoIndexMutex);
+    if (m_geoIndex && m_geoIndexDirectory == directory && !m_geoIndex->stale())
+    {
+        return m_geoIndex;
+    }
+    try
+    {
+        // 文件缺失或损坏时索引接受所有分类，规则保持原样
+        auto index = std::make_shared<V2rayConfigWin::GeoIndex>();
+        if (!index->open(directory))
+        {
+            OutputDebugStringA("Geo data files missing or malformed, geo rules are not checked\n");
+        }
+        m_geoIndex = std::move(index);
+        m_geoIndexDirectory = directory;
+    }
+    catch (std::exception const& ex)
+    {
+        OutputDebugStringA(("EnsureGeoIndexLoaded failed: " + std::string(ex.what()) + "\n").c_str());
+    }
+    return m_geoIndex;
+}
+
+void ReactLocalStorage::EnsureDbOpen() noexcept
+{
+    if (m_storage)
+    {
+        return; // Already open
+    }
+
+    m_storage = StorageCore::Acquire(GetDbPath());
+}
+
+void ReactLocalStorage::CloseDb() noexcept
+{
+    m_storage.reset();
+}
+
 ReactLocalStorage::~ReactLocalStorage()
 {
+    SaveConfigCache();
     CloseDb();
 }
 // See https://microsoft.github.io/react-native-windows/docs/native-modules for details on writing native modules
@@ -156,102 +336,246 @@ double ReactLocalStorage::multiply(double a, double b) noexcept {
 void ReactLocalStorage::setItem(std::string value, std::string key) noexcept
 {
     EnsureDbOpen();
-    if (!m_db) return;
+    if (!m_storage) return;
 
-    const char* sql = "INSERT OR REPLACE INTO key_value_store (item_key, item_value) VALUES (?, ?);";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr);
+    m_storage->SetItem(std::move(key), std::move(value));
+}
 
-    if (rc != SQLITE_OK)
-    {
-        OutputDebugStringA(("setItem: Failed to prepare statement: " + std::string(sqlite3_errmsg(m_db)) + "\n").c_str());
-        return;
-    }
+std::optional<std::string> ReactLocalStorage::getItem(std::string key) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return std::nullopt;
 
-    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, value.c_str(), -1, SQLITE_STATIC);
+    return m_storage->GetItem(key);
+}
 
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
-    {
-        OutputDebugStringA(("setItem: Failed to execute statement: " + std::string(sqlite3_errmsg(m_db)) + "\n").c_str());
-    }
-    sqlite3_finalize(stmt);
+void ReactLocalStorage::removeItem(std::string key) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return;
+
+    m_storage->RemoveItem(std::move(key));
 }
 
-std::optional<std::string> ReactLocalStorage::getItem(std::string key) noexcept
+void ReactLocalStorage::clear() noexcept
 {
     EnsureDbOpen();
-    if (!m_db) return std::nullopt;
+    if (!m_storage) return;
+
+    m_storage->Clear();
+}
 
-    const char* sql = "SELECT item_value FROM key_value_store WHERE item_key = ?;";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr);
+void ReactLocalStorage::setDouble(double value, std::string key) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return;
+
+    m_storage->SetNumber(std::move(key), value);
+}
 
-    if (rc != SQLITE_OK)
+std::optional<double> ReactLocalStorage::getDouble(std::string key) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return std::nullopt;
+
+    auto number = m_storage->GetNumber(key);
+    if (!number) return std::nullopt;
+    return std::visit([](auto v) { return static_cast<double>(v); }, *number);
+}
+
+void ReactLocalStorage::setInt64(double value, std::string key) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return;
+
+    // JS numbers are doubles; only whole values inside the int64 range are stored.
+    auto integer = StorageCore::ExactInt64(value);
+    if (!integer)
     {
-        OutputDebugStringA(("getItem: Failed to prepare statement: " + std::string(sqlite3_errmsg(m_db)) + "\n").c_str());
-        return std::nullopt;
+        OutputDebugStringA("setInt64: value is not representable as int64\n");
+        return;
     }
+    m_storage->SetNumber(std::move(key), *integer);
+}
+
+std::optional<double> ReactLocalStorage::getInt64(std::string key) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return std::nullopt;
+
+    auto number = m_storage->GetNumber(key);
+    if (!number) return std::nullopt;
+    // A REAL stored by setDouble only reads back if it is a whole int64.
+    if (auto integer = std::get_if<int64_t>(&*number)) return static_cast<double>(*integer);
+    auto integer = StorageCore::ExactInt64(std::get<double>(*number));
+    if (!integer) return std::nullopt;
+    return static_cast<double>(*integer);
+}
 
-    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+std::optional<double> ReactLocalStorage::incrementInt64(std::string key, double delta) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return std::nullopt;
 
-    std::optional<std::string> result = std::nullopt;
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW)
+    auto step = StorageCore::ExactInt64(delta);
+    if (!step)
     {
-        const unsigned char* text = sqlite3_column_text(stmt, 0);
-        if (text)
-        {
-            result = reinterpret_cast<const char*>(text);
-        }
+        OutputDebugStringA("incrementInt64: delta is not representable as int64\n");
+        return std::nullopt;
     }
-    else if (rc != SQLITE_DONE) // SQLITE_DONE means no row found, which is fine
+    auto next = m_storage->IncrementInt64(std::move(key), *step);
+    if (!next)
     {
-        OutputDebugStringA(("getItem: Failed to execute statement: " + std::string(sqlite3_errmsg(m_db)) + "\n").c_str());
+        OutputDebugStringA("incrementInt64: stored value is not an integer or the sum overflows int64\n");
+        return std::nullopt;
     }
-    sqlite3_finalize(stmt);
-    return result;
+    return static_cast<double>(*next);
 }
 
-void ReactLocalStorage::removeItem(std::string key) noexcept
+void ReactLocalStorage::setBool(bool value, std::string key) noexcept
 {
     EnsureDbOpen();
-    if (!m_db) return;
+    if (!m_storage) return;
 
-    const char* sql = "DELETE FROM key_value_store WHERE item_key = ?;";
-    sqlite3_stmt* stmt = nullptr;
-    int rc = sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr);
+    m_storage->SetNumber(std::move(key), static_cast<int64_t>(value ? 1 : 0));
+}
 
-    if (rc != SQLITE_OK)
+std::optional<bool> ReactLocalStorage::getBool(std::string key) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return std::nullopt;
+
+    auto number = m_storage->GetNumber(key);
+    if (!number) return std::nullopt;
+    return std::visit([](auto v) { return v != 0; }, *number);
+}
+
+void ReactLocalStorage::enableSearchIndex(std::string prefix) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return;
+
+    m_storage->EnableSearchIndex(std::move(prefix));
+}
+
+void ReactLocalStorage::disableSearchIndex(std::string prefix) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage) return;
+
+    m_storage->DisableSearchIndex(std::move(prefix));
+}
+
+void ReactLocalStorage::search(std::string prefix, std::string query, double limit, winrt::Microsoft::ReactNative::ReactPromise<std::vector<std::string>> &&result) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage)
     {
-        OutputDebugStringA(("removeItem: Failed to prepare statement: " + std::string(sqlite3_errmsg(m_db)) + "\n").c_str());
+        result.Reject(winrt::Microsoft::ReactNative::ReactError{ "E_STORAGE_UNAVAILABLE", "Database is not open." });
         return;
     }
 
-    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+    int maxResults = limit > 0 ? static_cast<int>(std::min(limit, 10000.0)) : 0;
+    // Resolved from the storage writer thread; the JS thread doesn't wait.
+    m_storage->Search(std::move(prefix), std::move(query), maxResults, [result](std::vector<std::string> keys) {
+        result.Resolve(keys);
+    });
+}
 
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
+void ReactLocalStorage::importAsyncStorageDump(std::string path, winrt::Microsoft::ReactNative::ReactPromise<double> &&result) noexcept
+{
+    EnsureDbOpen();
+    if (!m_storage)
     {
-        OutputDebugStringA(("removeItem: Failed to execute statement: " + std::string(sqlite3_errmsg(m_db)) + "\n").c_str());
+        result.Reject(winrt::Microsoft::ReactNative::ReactError{ "E_STORAGE_UNAVAILABLE", "Database is not open." });
+        return;
     }
-    sqlite3_finalize(stmt);
+
+    // Callbacks run on the storage writer thread and may outlive this module,
+    // so they hold their own copy of the context rather than |this|.
+    auto onProgress = [context = m_context](StorageCore::ImportProgress const& progress) {
+        if (!context) return;
+        context.EmitJSEvent(
+            L"RCTDeviceEventEmitter",
+            L"StorageImportProgress",
+            JSValueArgWriter(
+                [&progress](IJSValueWriter const& writer) noexcept {
+                    writer.WriteObjectBegin();
+                    writer.WritePropertyName(L"imported");
+                    writer.WriteDouble(static_cast<double>(progress.imported));
+                    writer.WritePropertyName(L"bytesRead");
+                    writer.WriteDouble(static_cast<double>(progress.bytesRead));
+                    writer.WritePropertyName(L"totalBytes");
+                    writer.WriteDouble(static_cast<double>(progress.totalBytes));
+                    writer.WriteObjectEnd();
+                }
+            )
+        );
+    };
+    auto onComplete = [result](bool ok, uint64_t imported, std::string const& error) {
+        if (ok)
+        {
+            result.Resolve(static_cast<double>(imported));
+        }
+        else
+        {
+            result.Reject(winrt::Microsoft::ReactNative::ReactError{ "E_IMPORT_FAILED", error });
+        }
+    };
+    m_storage->ImportJsonDump(std::move(path), std::move(onProgress), std::move(onComplete));
 }
 
-void ReactLocalStorage::clear() noexcept
+void ReactLocalStorage::reportMemoryPressure(double level) noexcept
 {
-    EnsureDbOpen();
-    if (!m_db) return;
+    auto pressure = level >= 2 ? MemoryPressure::Critical : level >= 1 ? MemoryPressure::Moderate : MemoryPressure::Normal;
+    MemoryGovernor::Instance().SetPressure(pressure);
+}
 
-    const char* sql = "DELETE FROM key_value_store;";
-    char* errMsg = nullptr;
-    int rc = sqlite3_exec(m_db, sql, nullptr, nullptr, &errMsg);
-    if (rc != SQLITE_OK)
-    {
-        OutputDebugStringA(("clear: Failed to execute statement: " + std::string(errMsg) + "\n").c_str());
-        sqlite3_free(errMsg);
-    }
+ReactLocalStorageCodegen::ReactLocalStorageSpec_MemoryFootprint ReactLocalStorage::getMemoryFootprint() noexcept
+{
+    auto footprint = MemoryGovernor::Instance().CurrentFootprint();
+
+    ReactLocalStorageCodegen::ReactLocalStorageSpec_MemoryFootprint result{};
+    result.sqliteHeapBytes = static_cast<double>(footprint.sqliteHeapBytes);
+    result.sqliteHeapHighwater = static_cast<double>(footprint.sqliteHeapHighwater);
+    result.sqliteSoftHeapLimit = static_cast<double>(footprint.sqliteSoftHeapLimit);
+    result.pageCacheKiB = static_cast<double>(footprint.pageCacheKiB);
+    result.cacheBytes = static_cast<double>(footprint.cacheBytes);
+    result.cacheBudgetBytes = static_cast<double>(footprint.cacheBudgetBytes);
+    result.pressureLevel = static_cast<double>(static_cast<int>(footprint.pressure));
+    return result;
+}
+
+void ReactLocalStorage::importSubscription(std::string subscription, winrt::Microsoft::ReactNative::ReactPromise<ReactLocalStorageCodegen::ReactLocalStorageSpec_SubscriptionImport> &&result) noexcept
+{
+    // 解析在后台线程进行，importBatch 自身再分发到多个工作线程。
+    // 线程只持有缓存状态，模块先于线程销毁也不受影响
+    std::thread([state = m_serverCache, path = GetServerCachePath(), subscription = std::move(subscription), result]() mutable {
+        try
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->EnsureLoaded(path);
+
+            auto batch = V2rayConfigWin::AngConfigManager::importBatch(subscription, 0, true, &state->cache);
+            // 每批只写一次磁盘
+            if (state->cache.dirty() && !state->path.empty())
+            {
+                LogCacheFileResult("Saving server cache", state->cache.save(state->path));
+            }
+            state->Settle();
+
+            ReactLocalStorageCodegen::ReactLocalStorageSpec_SubscriptionImport summary{};
+            summary.imported = static_cast<double>(batch.configs.size());
+            summary.duplicates = static_cast<double>(batch.merges.size());
+            summary.failed = static_cast<double>(batch.status.size() - batch.configs.size() - batch.merges.size());
+            summary.cacheHits = static_cast<double>(batch.cacheHits);
+            result.Resolve(summary);
+        }
+        catch (std::exception const& ex)
+        {
+            result.Reject(winrt::Microsoft::ReactNative::ReactError{ "E_IMPORT_FAILED", ex.what() });
+        }
+    }).detach();
 }
 
 void ReactLocalStorage::SendLogToJS(std::string const& message) noexcept {
@@ -319,22 +643,29 @@ void ReactLocalStorage::V2RayThreadWorker(std::string config)
     try
     {
         //SendLogToJS("V2Ray thread started.");
-        std::optional<V2rayConfigWin::ServerConfig> result = V2rayConfigWin::AngConfigManager::importConfig(config);
+        std::optional<V2rayConfigWin::ServerConfig> result = ImportLink(config);
         if (!result.has_value()) {
             //SendLogToJS("Error: Failed to parse V2Ray config.");
             return;
         }
 
-        std::optional<std::string> configStrOpt = V2rayConfigWin::V2rayConfigGenerator::generate(result.value(), V2rayConfigWin::V2rayGeneratorSettings{});
+        // 注意：在实际应用中，这个路径应该是动态获取或打包到应用内的
+        const std::string envPath = "F:\\dev\\apps\\react-local-storage\\windows\\ReactLocalStorage\\libv2ray";
+
+        // 规则中引用了 geo 文件里不存在的分类时，直接剔除，避免核心启动失败
+        V2rayConfigWin::V2rayGeneratorSettings settings;
+        // geoIndex 持有索引直到配置生成完毕，期间文件被替换也不会影响本次生成
+        std::shared_ptr<V2rayConfigWin::GeoIndex const> geoIndex = EnsureGeoIndexLoaded(envPath);
+        settings.geoCatalog = geoIndex.get();
+        std::optional<std::string> configStrOpt = GenerateConfig(result.value(), settings);
         if (!configStrOpt.has_value()) {
             //SendLogToJS("Error: Failed to generate V2Ray JSON config string.");
             return;
         }
         
         // InitV2Env 只需要调用一次
-        // 注意：在实际应用中，这个路径应该是动态获取或打包到应用内的
         std::string baseKey = getDeviceIdForXUDPBaseKey();
-        m_v2rayManager.InitV2Env("F:\\dev\\apps\\react-local-storage\\windows\\ReactLocalStorage\\libv2ray", baseKey);
+        m_v2rayManager.InitV2Env(envPath, baseKey);
         //SendLogToJS("InitV2Env completed.");
 
         m_v2rayManager.SetCallbacks(&OnSetup, &OnPrepare, &OnShutdown, &OnProtect, &OnEmitStatus);
@@ -12,10 +12,14 @@
 #include <optional> // Required for std::optional
 #include <string>   // Required for std::string
 #include "V2rayManager.h"
+#include "V2rayServerTable.h"
+#include "V2rayConfigCache.h"
+#include "V2rayGeoIndex.h"
+#include "StorageCore.h"
+#include <atomic>
+#include <memory>
 #include <thread>          // 包含线程库
 #include <mutex>           // 包含互斥锁库
-// Forward declare sqlite3
-struct sqlite3;
 namespace winrt::ReactLocalStorage
 {
 
@@ -79,6 +83,48 @@ struct ReactLocalStorage
   REACT_METHOD(copyTheInviteCode)
   void copyTheInviteCode(std::string code) noexcept;
 
+  REACT_METHOD(setDouble)
+  void setDouble(double value, std::string key) noexcept;
+
+  REACT_SYNC_METHOD(getDouble)
+  std::optional<double> getDouble(std::string key) noexcept;
+
+  REACT_METHOD(setInt64)
+  void setInt64(double value, std::string key) noexcept;
+
+  REACT_SYNC_METHOD(getInt64)
+  std::optional<double> getInt64(std::string key) noexcept;
+
+  REACT_SYNC_METHOD(incrementInt64)
+  std::optional<double> incrementInt64(std::string key, double delta) noexcept;
+
+  REACT_METHOD(setBool)
+  void setBool(bool value, std::string key) noexcept;
+
+  REACT_SYNC_METHOD(getBool)
+  std::optional<bool> getBool(std::string key) noexcept;
+
+  REACT_METHOD(enableSearchIndex)
+  void enableSearchIndex(std::string prefix) noexcept;
+
+  REACT_METHOD(disableSearchIndex)
+  void disableSearchIndex(std::string prefix) noexcept;
+
+  REACT_METHOD(search)
+  void search(std::string prefix, std::string query, double limit, winrt::Microsoft::ReactNative::ReactPromise<std::vector<std::string>> &&result) noexcept;
+
+  REACT_METHOD(importAsyncStorageDump)
+  void importAsyncStorageDump(std::string path, winrt::Microsoft::ReactNative::ReactPromise<double> &&result) noexcept;
+
+  REACT_METHOD(reportMemoryPressure)
+  void reportMemoryPressure(double level) noexcept;
+
+  REACT_SYNC_METHOD(getMemoryFootprint)
+  ReactLocalStorageCodegen::ReactLocalStorageSpec_MemoryFootprint getMemoryFootprint() noexcept;
+
+  REACT_METHOD(importSubscription)
+  void importSubscription(std::string subscription, winrt::Microsoft::ReactNative::ReactPromise<ReactLocalStorageCodegen::ReactLocalStorageSpec_SubscriptionImport> &&result) noexcept;
+
   // FIX: Add required methods for NativeEventEmitter
   REACT_METHOD(addListener)
   void addListener(std::string const& eventName) noexcept;
@@ -88,7 +134,7 @@ struct ReactLocalStorage
 private:
   void SendLogToJS(std::string const& message) noexcept;
   React::ReactContext m_context;
-  sqlite3* m_db{nullptr}; // SQLite database connection
+  std::shared_ptr<StorageCore> m_storage; // Shared with other instances using the same DB
   // --- V2Ray 后台任务管理 ---
   V2rayManager m_v2rayManager;
   std::thread m_v2rayThread;
@@ -99,7 +145,50 @@ private:
   // 后台线程的工作函数
   void V2RayThreadWorker(std::string config);
 
+  // --- 已解析链接缓存（与数据库同目录） ---
+  // 后台导入线程持有 shared_ptr 而不是 this；最后一个持有者析构时写回磁盘
+  struct ServerCacheState : MemoryConsumer
+  {
+    V2rayConfigWin::ServerCache cache;
+    std::mutex mutex;
+    std::string path;
+    bool loaded{false};
+    std::atomic<size_t> usage{0};
+    std::atomic<size_t> pendingTrim{SIZE_MAX}; // 持锁期间收到的裁剪目标
+
+    ServerCacheState() noexcept;
+    ~ServerCacheState();
+    // 以下两个方法调用方需持有 mutex
+    void EnsureLoaded(std::string const& cachePath) noexcept;
+    // 应用延迟的裁剪与预算，并更新 usage；只裁内存，文件中仍保留被淘汰的条目
+    void Settle() noexcept;
+
+    // MemoryConsumer
+    size_t MemoryUsage() noexcept override;
+    void TrimMemory(size_t targetBytes) noexcept override;
+  };
+  std::shared_ptr<ServerCacheState> m_serverCache{std::make_shared<ServerCacheState>()};
+  std::optional<V2rayConfigWin::ServerConfig> ImportLink(std::string const& link) noexcept;
+
+  // --- 最近生成的核心配置缓存（与数据库同目录），模块析构时写回磁盘 ---
+  V2rayConfigWin::ConfigCache m_configCache;
+  std::mutex m_configCacheMutex;
+  std::string m_configCachePath;
+  bool m_configCacheLoaded{false};
+  std::optional<std::string> GenerateConfig(V2rayConfigWin::ServerConfig const& server,
+                                            V2rayConfigWin::V2rayGeneratorSettings const& settings) noexcept;
+  void SaveConfigCache() noexcept;
+
+  // --- 核心 geoip.dat / geosite.dat 的分类索引 ---
+  // 文件大小或修改时间变化时整体重建并替换，正在使用旧索引的调用方不受影响
+  std::shared_ptr<V2rayConfigWin::GeoIndex const> m_geoIndex;
+  std::string m_geoIndexDirectory;
+  std::mutex m_geoIndexMutex;
+  std::shared_ptr<V2rayConfigWin::GeoIndex const> EnsureGeoIndexLoaded(std::string const& directory) noexcept;
+
   std::string GetDbPath() noexcept;
+  std::string GetServerCachePath() noexcept;
+  std::string GetConfigCachePath() noexcept;
   void EnsureDbOpen() noexcept;
   void CloseDb() noexcept;
 };
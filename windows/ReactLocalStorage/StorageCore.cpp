@@ -0,0 +1,1064 @@
+#include "pch.h"
+
+#include "StorageCore.h"
+#include <winsqlite/winsqlite3.h>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace winrt::ReactLocalStorage
+{
+
+namespace
+{
+constexpr size_t kMaxWriteBatch = 512;
+constexpr int kBusyTimeoutMs = 5000;
+constexpr size_t kImportBatch = 10000;
+constexpr int kMaxCommitAttempts = 3;
+
+const char* const kCommitSql = "COMMIT;";
+
+const char* const kSelectItemSql = "SELECT item_value FROM key_value_store WHERE item_key = ?;";
+const char* const kUpsertItemSql = "INSERT OR REPLACE INTO key_value_store (item_key, item_value) VALUES (?, ?);";
+const char* const kDeleteItemSql = "DELETE FROM key_value_store WHERE item_key = ?;";
+const char* const kClearSql = "DELETE FROM key_value_store; DELETE FROM typed_value_store;";
+
+const char* const kSelectNumberSql = "SELECT item_value FROM typed_value_store WHERE item_key = ?;";
+const char* const kUpsertNumberSql = "INSERT OR REPLACE INTO typed_value_store (item_key, item_value) VALUES (?, ?);";
+const char* const kDeleteNumberSql = "DELETE FROM typed_value_store WHERE item_key = ?;";
+
+// key_value_fts is an external-content FTS5 table over key_value_store, so the
+// values are not stored twice. Triggers keep it in sync for keys under one of
+// the prefixes in search_prefixes.
+const char* const kSearchSchemaSql = R"(
+CREATE TABLE IF NOT EXISTS search_prefixes (prefix TEXT PRIMARY KEY NOT NULL);
+CREATE VIRTUAL TABLE IF NOT EXISTS key_value_fts USING fts5(
+    item_value, content='key_value_store', content_rowid='rowid', tokenize='unicode61 remove_diacritics 2');
+CREATE TRIGGER IF NOT EXISTS key_value_fts_ai AFTER INSERT ON key_value_store
+WHEN EXISTS (SELECT 1 FROM search_prefixes WHERE substr(new.item_key, 1, length(prefix)) = prefix)
+BEGIN
+    INSERT INTO key_value_fts (rowid, item_value) VALUES (new.rowid, new.item_value);
+END;
+CREATE TRIGGER IF NOT EXISTS key_value_fts_ad AFTER DELETE ON key_value_store
+WHEN EXISTS (SELECT 1 FROM search_prefixes WHERE substr(old.item_key, 1, length(prefix)) = prefix)
+BEGIN
+    INSERT INTO key_value_fts (key_value_fts, rowid, item_value) VALUES ('delete', old.rowid, old.item_value);
+END;
+CREATE TRIGGER IF NOT EXISTS key_value_fts_au AFTER UPDATE ON key_value_store
+BEGIN
+    INSERT INTO key_value_fts (key_value_fts, rowid, item_value) SELECT 'delete', old.rowid, old.item_value
+        WHERE EXISTS (SELECT 1 FROM search_prefixes WHERE substr(old.item_key, 1, length(prefix)) = prefix);
+    INSERT INTO key_value_fts (rowid, item_value) SELECT new.rowid, new.item_value
+        WHERE EXISTS (SELECT 1 FROM search_prefixes WHERE substr(new.item_key, 1, length(prefix)) = prefix);
+END;
+)";
+
+// Rows under ?1 that no other enabled prefix already covers.
+const char* const kIndexPrefixSql = R"(
+INSERT INTO key_value_fts (rowid, item_value)
+SELECT rowid, item_value FROM key_value_store
+WHERE substr(item_key, 1, length(?1)) = ?1
+  AND NOT EXISTS (SELECT 1 FROM search_prefixes WHERE substr(item_key, 1, length(prefix)) = prefix);
+)";
+const char* const kUnindexPrefixSql = R"(
+INSERT INTO key_value_fts (key_value_fts, rowid, item_value)
+SELECT 'delete', rowid, item_value FROM key_value_store
+WHERE substr(item_key, 1, length(?1)) = ?1
+  AND NOT EXISTS (SELECT 1 FROM search_prefixes WHERE substr(item_key, 1, length(prefix)) = prefix);
+)";
+const char* const kInsertPrefixSql = "INSERT OR IGNORE INTO search_prefixes (prefix) VALUES (?);";
+const char* const kDeletePrefixSql = "DELETE FROM search_prefixes WHERE prefix = ?;";
+const char* const kSearchSql = R"(
+SELECT s.item_key FROM key_value_fts JOIN key_value_store s ON s.rowid = key_value_fts.rowid
+WHERE key_value_fts MATCH ?1 AND substr(s.item_key, 1, length(?2)) = ?2
+ORDER BY key_value_fts.rank LIMIT ?3;
+)";
+
+void LogSqliteError(const char* what, sqlite3* db)
+{
+    OutputDebugStringA((std::string(what) + ": " + (db ? sqlite3_errmsg(db) : "no connection") + "\n").c_str());
+}
+
+// Turns free text into an FTS5 query: every whitespace separated term is
+// quoted (so user input can't inject operators) and prefix matched.
+std::string ToFtsQuery(std::string const& query)
+{
+    std::string out;
+    size_t i = 0;
+    while (i < query.size())
+    {
+        while (i < query.size() && std::isspace(static_cast<unsigned char>(query[i]))) ++i;
+        if (i >= query.size()) break;
+        if (!out.empty()) out += ' ';
+        out += '"';
+        while (i < query.size() && !std::isspace(static_cast<unsigned char>(query[i])))
+        {
+            if (query[i] == '"') out += '"';
+            out += query[i++];
+        }
+        out += "\"*";
+    }
+    return out;
+}
+
+std::vector<std::string> RunSearch(StorageConnection& db, std::string const& ftsQuery, std::string const& prefix, int limit)
+{
+    std::vector<std::string> keys;
+    sqlite3_stmt* stmt = db.Statement(kSearchSql);
+    if (!stmt) return keys;
+
+    sqlite3_bind_text(stmt, 1, ftsQuery.c_str(), static_cast<int>(ftsQuery.size()), SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, prefix.c_str(), static_cast<int>(prefix.size()), SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, limit);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        if (text)
+        {
+            keys.emplace_back(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, 0));
+        }
+    }
+    if (rc != SQLITE_DONE)
+    {
+        LogSqliteError("search: Failed to execute statement", db.Handle());
+    }
+    sqlite3_reset(stmt);
+    return keys;
+}
+
+bool StepWithText(StorageConnection& db, const char* sql, std::string const& text, const char* what)
+{
+    sqlite3_stmt* stmt = db.Statement(sql);
+    if (!stmt) return false;
+    sqlite3_bind_text(stmt, 1, text.c_str(), static_cast<int>(text.size()), SQLITE_STATIC);
+    bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!ok) LogSqliteError(what, db.Handle());
+    sqlite3_reset(stmt);
+    return ok;
+}
+
+// SAX consumer for {"key": value, ...}. Top-level string values are passed
+// through as-is; anything else is re-serialized to JSON text, building a
+// small DOM only for the nested value currently being read.
+class AsyncStorageDumpSax : public nlohmann::json_sax<nlohmann::json>
+{
+public:
+    using json = nlohmann::json;
+    using Emit = std::function<bool(std::string const& key, std::string const& value)>;
+
+    explicit AsyncStorageDumpSax(Emit emit) : m_emit(std::move(emit)) {}
+
+    std::string const& Error() const noexcept { return m_error; }
+
+    bool null() override { return m_depth == 1 ? true : AddNested(nullptr); }
+    bool boolean(bool val) override { return m_depth == 1 ? m_emit(m_key, val ? "true" : "false") : AddNested(val); }
+    bool number_integer(number_integer_t val) override { return m_depth == 1 ? m_emit(m_key, std::to_string(val)) : AddNested(val); }
+    bool number_unsigned(number_unsigned_t val) override { return m_depth == 1 ? m_emit(m_key, std::to_string(val)) : AddNested(val); }
+    bool number_float(number_float_t val, string_t const& raw) override { return m_depth == 1 ? m_emit(m_key, raw) : AddNested(val); }
+    bool string(string_t& val) override { return m_depth == 1 ? m_emit(m_key, val) : AddNested(std::move(val)); }
+    bool binary(binary_t& val) override { return m_depth == 1 ? Fail("binary values are not supported") : AddNested(json::binary(std::move(val))); }
+
+    bool start_object(std::size_t) override { return StartContainer(json::object()); }
+    bool start_array(std::size_t) override
+    {
+        if (m_depth == 0) return Fail("dump must be a JSON object");
+        return StartContainer(json::array());
+    }
+
+    bool key(string_t& val) override
+    {
+        if (m_depth == 1) m_key = std::move(val);
+        else m_nestedKey = std::move(val);
+        return true;
+    }
+
+    bool end_object() override { return EndContainer(); }
+    bool end_array() override { return EndContainer(); }
+
+    bool parse_error(std::size_t position, std::string const&, nlohmann::detail::exception const& ex) override
+    {
+        return Fail("parse error at byte " + std::to_string(position) + ": " + ex.what());
+    }
+
+private:
+    bool Fail(std::string message)
+    {
+        m_error = std::move(message);
+        return false;
+    }
+
+    bool AddNested(json value)
+    {
+        if (m_stack.empty()) return Fail("dump must be a JSON object");
+        json& parent = *m_stack.back();
+        if (parent.is_array())
+        {
+            parent.push_back(std::move(value));
+        }
+        else
+        {
+            parent[m_nestedKey] = std::move(value);
+        }
+        return true;
+    }
+
+    bool StartContainer(json container)
+    {
+        ++m_depth;
+        if (m_depth == 1) return true; // the dump object itself
+        if (m_depth == 2)
+        {
+            m_nested = std::move(container);
+            m_stack.assign(1, &m_nested);
+            return true;
+        }
+        json& parent = *m_stack.back();
+        json* child = parent.is_array() ? &(parent.push_back(std::move(container)), parent.back())
+                                        : &(parent[m_nestedKey] = std::move(container));
+        m_stack.push_back(child);
+        return true;
+    }
+
+    bool EndContainer()
+    {
+        --m_depth;
+        if (m_depth == 0) return true;
+        m_stack.pop_back();
+        if (m_depth == 1)
+        {
+            bool ok = m_emit(m_key, m_nested.dump());
+            m_nested = nullptr;
+            return ok;
+        }
+        return true;
+    }
+
+    Emit m_emit;
+    int m_depth{0};
+    std::string m_key;
+    std::string m_nestedKey;
+    json m_nested;
+    std::vector<json*> m_stack;
+    std::string m_error;
+};
+
+std::mutex& RegistryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_map<std::string, std::weak_ptr<StorageCore>>& Registry()
+{
+    static std::unordered_map<std::string, std::weak_ptr<StorageCore>> registry;
+    return registry;
+}
+} // namespace
+
+// =================================================================
+// StorageConnection
+// =================================================================
+
+StorageConnection::~StorageConnection()
+{
+    Close();
+}
+
+bool StorageConnection::Open(std::string const& path, bool readOnly) noexcept
+{
+    int flags = readOnly ? SQLITE_OPEN_READONLY : (SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    int rc = sqlite3_open_v2(path.c_str(), &m_db, flags, nullptr);
+    if (rc != SQLITE_OK)
+    {
+        LogSqliteError("Failed to open database", m_db);
+        sqlite3_close(m_db); // sqlite3_close can be called on a null pointer or an unopened db
+        m_db = nullptr;
+        return false;
+    }
+    sqlite3_busy_timeout(m_db, kBusyTimeoutMs);
+    return true;
+}
+
+void StorageConnection::Close() noexcept
+{
+    for (auto& [sql, stmt] : m_statements)
+    {
+        sqlite3_finalize(stmt);
+    }
+    m_statements.clear();
+    if (m_db)
+    {
+        sqlite3_close(m_db);
+        m_db = nullptr;
+    }
+}
+
+sqlite3_stmt* StorageConnection::Statement(const char* sql) noexcept
+{
+    if (!m_db) return nullptr;
+
+    auto it = m_statements.find(sql);
+    if (it != m_statements.end())
+    {
+        sqlite3_reset(it->second);
+        sqlite3_clear_bindings(it->second);
+        return it->second;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(m_db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+    {
+        LogSqliteError("Failed to prepare statement", m_db);
+        return nullptr;
+    }
+    m_statements.emplace(sql, stmt);
+    return stmt;
+}
+
+void StorageConnection::SetPageCacheKiB(int kib) noexcept
+{
+    if (!m_db || kib == m_pageCacheKiB) return;
+
+    // Negative cache_size is in KiB rather than pages.
+    std::string sql = "PRAGMA cache_size=-" + std::to_string(kib) + ";";
+    if (sqlite3_exec(m_db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK)
+    {
+        m_pageCacheKiB = kib;
+    }
+}
+
+bool StorageConnection::Exec(const char* sql) noexcept
+{
+    if (!m_db) return false;
+
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(m_db, sql, nullptr, nullptr, &errMsg);
+    if (rc != SQLITE_OK)
+    {
+        OutputDebugStringA(("Failed to execute '" + std::string(sql) + "': " + std::string(errMsg ? errMsg : "") + "\n").c_str());
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// =================================================================
+// StorageCore::ReaderPool
+// =================================================================
+
+std::unique_ptr<StorageConnection> StorageCore::ReaderPool::Take() noexcept
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_idle.empty() && m_opened < kMaxReaders)
+    {
+        ++m_opened;
+        lock.unlock();
+        auto connection = std::make_unique<StorageConnection>();
+        if (connection->Open(m_path, true))
+        {
+            connection->SetPageCacheKiB(MemoryGovernor::Instance().PageCacheKiB());
+            return connection;
+        }
+        lock.lock();
+        --m_opened;
+        m_available.notify_one();
+        return nullptr;
+    }
+
+    m_available.wait(lock, [this] { return !m_idle.empty(); });
+    auto connection = std::move(m_idle.back());
+    m_idle.pop_back();
+    lock.unlock();
+    connection->SetPageCacheKiB(MemoryGovernor::Instance().PageCacheKiB());
+    return connection;
+}
+
+void StorageCore::ReaderPool::Return(std::unique_ptr<StorageConnection> connection) noexcept
+{
+    if (!connection) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.push_back(std::move(connection));
+    }
+    m_available.notify_one();
+}
+
+void StorageCore::ReaderPool::CloseAll() noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_opened -= m_idle.size();
+    m_idle.clear();
+}
+
+// =================================================================
+// StorageCore
+// =================================================================
+
+std::shared_ptr<StorageCore> StorageCore::Acquire(std::string const& dbPath) noexcept
+{
+    if (dbPath.empty())
+    {
+        OutputDebugStringA("DB path is empty, cannot open database.\n");
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    auto& registry = Registry();
+    // Cores never touch the registry themselves; drop the ones that are gone.
+    std::erase_if(registry, [](auto const& entry) { return entry.second.expired(); });
+    if (auto it = registry.find(dbPath); it != registry.end())
+    {
+        if (auto existing = it->second.lock())
+        {
+            return existing;
+        }
+    }
+
+    std::shared_ptr<StorageCore> core(new StorageCore(dbPath));
+    if (!core->Open())
+    {
+        return nullptr;
+    }
+    registry[dbPath] = core;
+    return core;
+}
+
+StorageCore::StorageCore(std::string path) : m_path(path), m_readers(std::move(path))
+{
+}
+
+// Must not lock RegistryMutex(): a core that fails to open is destroyed
+// inside Acquire while it is held.
+StorageCore::~StorageCore()
+{
+    MemoryGovernor::Instance().Unregister(this);
+    Close();
+}
+
+bool StorageCore::Open() noexcept
+{
+    if (!m_writer.Open(m_path, false))
+    {
+        return false;
+    }
+
+    // WAL lets the reader pool run alongside the writer thread.
+    m_writer.Exec("PRAGMA journal_mode=WAL;");
+    m_writer.Exec("PRAGMA synchronous=NORMAL;");
+    // INSERT OR REPLACE only fires the search index delete trigger with this on.
+    m_writer.Exec("PRAGMA recursive_triggers=ON;");
+
+    // Create tables if they don't exist. typed_value_store declares no column
+    // type so SQLite keeps INTEGER and REAL values in their native form.
+    if (!m_writer.Exec("CREATE TABLE IF NOT EXISTS key_value_store (item_key TEXT PRIMARY KEY NOT NULL, item_value TEXT);") ||
+        !m_writer.Exec("CREATE TABLE IF NOT EXISTS typed_value_store (item_key TEXT PRIMARY KEY NOT NULL, item_value);"))
+    {
+        m_writer.Close(); // Close DB if table creation fails
+        return false;
+    }
+
+    m_writer.SetPageCacheKiB(MemoryGovernor::Instance().PageCacheKiB());
+    m_writerThread = std::thread(&StorageCore::WriterLoop, this);
+    MemoryGovernor::Instance().Register(this);
+    return true;
+}
+
+void StorageCore::Close() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopping = true;
+    }
+    m_queueChanged.notify_all();
+    if (m_writerThread.joinable())
+    {
+        m_writerThread.join();
+    }
+    m_readers.CloseAll();
+    m_writer.Close();
+}
+
+void StorageCore::Enqueue(WriteTask task) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_queue.push_back(std::move(task));
+    }
+    m_queueChanged.notify_all();
+}
+
+void StorageCore::WriterLoop() noexcept
+{
+    std::vector<WriteTask> batch;
+    batch.reserve(kMaxWriteBatch);
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_writerBusy = false;
+            m_queueChanged.notify_all();
+            m_queueChanged.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty())
+            {
+                return; // stopping and fully drained
+            }
+            // Exclusive tasks never share a batch with anything else.
+            while (!m_queue.empty() && batch.size() < kMaxWriteBatch)
+            {
+                if (m_queue.front().exclusive && !batch.empty()) break;
+                batch.push_back(std::move(m_queue.front()));
+                m_queue.pop_front();
+                if (batch.back().exclusive) break;
+            }
+            m_writerBusy = true;
+        }
+
+        if (batch.front().exclusive)
+        {
+            batch.front().apply(m_writer);
+            batch.clear();
+            continue;
+        }
+
+        m_writer.SetPageCacheKiB(MemoryGovernor::Instance().PageCacheKiB());
+
+        std::vector<bool> committed(batch.size(), false);
+        if (!CommitBatch(batch, committed))
+        {
+            OutputDebugStringA(("Dropping " + std::to_string(batch.size()) + " writes that could not be committed\n").c_str());
+        }
+        ReleaseBatch(batch, committed);
+        batch.clear();
+    }
+}
+
+// Applies |batch| in one transaction. |applied| reports which tasks are now
+// durable: all that applied cleanly once COMMIT is done, none if it never is.
+// A failed BEGIN or COMMIT is rolled back and the whole batch retried.
+bool StorageCore::CommitBatch(std::vector<WriteTask>& batch, std::vector<bool>& applied) noexcept
+{
+    for (int attempt = 0; attempt < kMaxCommitAttempts; ++attempt)
+    {
+        // A transaction some earlier task failed to finish would make every
+        // BEGIN fail; its changes were never reported durable, so drop them.
+        if (!sqlite3_get_autocommit(m_writer.Handle()))
+        {
+            OutputDebugStringA("Rolling back a transaction left open on the writer connection\n");
+            m_writer.Exec("ROLLBACK;");
+        }
+        if (!m_writer.Exec("BEGIN IMMEDIATE;"))
+        {
+            continue;
+        }
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            applied[i] = batch[i].apply(m_writer);
+        }
+
+        sqlite3_stmt* commit = m_writer.Statement(kCommitSql);
+        bool ok = commit && sqlite3_step(commit) == SQLITE_DONE;
+        if (commit) sqlite3_reset(commit);
+        if (ok)
+        {
+            return true;
+        }
+        LogSqliteError("Failed to commit write batch", m_writer.Handle());
+        m_writer.Exec("ROLLBACK;");
+    }
+    applied.assign(batch.size(), false);
+    return false;
+}
+
+void StorageCore::ReleaseBatch(std::vector<WriteTask> const& batch, std::vector<bool> const& committed) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        auto const& task = batch[i];
+        if (task.isClear && m_pendingClears > 0)
+        {
+            // A failed clear leaves the cache emptier than the database,
+            // which read-through fills correct.
+            --m_pendingClears;
+        }
+        if (!task.key)
+        {
+            continue;
+        }
+        if (committed[i])
+        {
+            if (task.touchesItems) m_cache.Release(*task.key);
+            if (task.touchesNumbers) m_numbers.Release(*task.key);
+        }
+        else
+        {
+            if (task.touchesItems) m_cache.Discard(*task.key);
+            if (task.touchesNumbers) m_numbers.Discard(*task.key);
+        }
+    }
+    // Entries that just became idle may now be evicted.
+    EnforceCacheBudgetLocked();
+}
+
+void StorageCore::EnforceCacheBudgetLocked() noexcept
+{
+    size_t budget = MemoryGovernor::Instance().CacheBudgetBytes();
+    if (m_cache.Bytes() + m_numbers.Bytes() <= budget) return;
+
+    // Numbers are tiny; shrink the string cache first.
+    m_cache.Trim(budget > m_numbers.Bytes() ? budget - m_numbers.Bytes() : 0);
+    if (m_cache.Bytes() + m_numbers.Bytes() > budget)
+    {
+        m_numbers.Trim(budget > m_cache.Bytes() ? budget - m_cache.Bytes() : 0);
+    }
+}
+
+size_t StorageCore::MemoryUsage() noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    return m_cache.Bytes() + m_numbers.Bytes();
+}
+
+void StorageCore::TrimMemory(size_t targetBytes) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_cache.Trim(targetBytes > m_numbers.Bytes() ? targetBytes - m_numbers.Bytes() : 0);
+    m_numbers.Trim(targetBytes > m_cache.Bytes() ? targetBytes - m_cache.Bytes() : 0);
+}
+
+void StorageCore::Flush() noexcept
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_queueChanged.wait(lock, [this] { return m_stopping || (m_queue.empty() && !m_writerBusy); });
+}
+
+std::optional<std::string> StorageCore::ReadItem(std::string const& key) noexcept
+{
+    auto connection = m_readers.Take();
+    if (!connection) return std::nullopt;
+
+    std::optional<std::string> result = std::nullopt;
+    if (sqlite3_stmt* stmt = connection->Statement(kSelectItemSql))
+    {
+        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW)
+        {
+            const unsigned char* text = sqlite3_column_text(stmt, 0);
+            if (text)
+            {
+                result = std::string(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, 0));
+            }
+        }
+        else if (rc != SQLITE_DONE) // SQLITE_DONE means no row found, which is fine
+        {
+            LogSqliteError("getItem: Failed to execute statement", connection->Handle());
+        }
+        sqlite3_reset(stmt);
+    }
+    m_readers.Return(std::move(connection));
+    return result;
+}
+
+void StorageCore::SetItem(std::string key, std::string value) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    ++m_cache.Put(key, value).pendingWrites;
+    ++m_writeEpoch;
+    EnforceCacheBudgetLocked();
+
+    // Enqueue under the cache lock so queue order matches cache order.
+    WriteTask task;
+    task.key = key;
+    task.touchesItems = true;
+    task.apply = [key = std::move(key), value = std::move(value)](StorageConnection& db) {
+        sqlite3_stmt* stmt = db.Statement(kUpsertItemSql);
+        if (!stmt) return false;
+        sqlite3_bind_text(stmt, 1, key.c_str(), static_cast<int>(key.size()), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, value.c_str(), static_cast<int>(value.size()), SQLITE_STATIC);
+        bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+        if (!ok) LogSqliteError("setItem: Failed to execute statement", db.Handle());
+        sqlite3_reset(stmt);
+        return ok;
+    };
+    Enqueue(std::move(task));
+}
+
+std::optional<std::string> StorageCore::GetItem(std::string const& key) noexcept
+{
+    uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        if (auto* entry = m_cache.Find(key))
+        {
+            return entry->value;
+        }
+        if (m_pendingClears > 0)
+        {
+            // Everything not in the cache was wiped by a clear still in flight.
+            return std::nullopt;
+        }
+        epoch = m_writeEpoch;
+    }
+
+    auto value = ReadItem(key);
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if (epoch == m_writeEpoch)
+    {
+        m_cache.Put(key, value);
+        EnforceCacheBudgetLocked();
+    }
+    return value;
+}
+
+void StorageCore::RemoveItem(std::string key) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    ++m_cache.Put(key, std::nullopt).pendingWrites;
+    ++m_numbers.Put(key, std::nullopt).pendingWrites;
+    ++m_writeEpoch;
+    EnforceCacheBudgetLocked();
+
+    WriteTask task;
+    task.key = key;
+    task.touchesItems = true;
+    task.touchesNumbers = true;
+    task.apply = [key = std::move(key)](StorageConnection& db) {
+        bool ok = true;
+        for (const char* sql : { kDeleteItemSql, kDeleteNumberSql })
+        {
+            sqlite3_stmt* stmt = db.Statement(sql);
+            if (!stmt) return false;
+            sqlite3_bind_text(stmt, 1, key.c_str(), static_cast<int>(key.size()), SQLITE_STATIC);
+            if (sqlite3_step(stmt) != SQLITE_DONE)
+            {
+                LogSqliteError("removeItem: Failed to execute statement", db.Handle());
+                ok = false;
+            }
+            sqlite3_reset(stmt);
+        }
+        return ok;
+    };
+    Enqueue(std::move(task));
+}
+
+void StorageCore::Clear() noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    m_cache.Clear();
+    m_numbers.Clear();
+    ++m_pendingClears;
+    ++m_writeEpoch;
+
+    WriteTask task;
+    task.isClear = true;
+    task.apply = [](StorageConnection& db) { return db.Exec(kClearSql); };
+    Enqueue(std::move(task));
+}
+
+void StorageCore::InvalidateImported(std::vector<std::string> const& keys) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    ++m_writeEpoch; // drop read-through fills that raced with the import
+    for (auto const& key : keys)
+    {
+        m_cache.EraseIfIdle(key);
+    }
+}
+
+void StorageCore::ImportJsonDump(std::string path, ImportProgressCallback onProgress, ImportCompleteCallback onComplete) noexcept
+{
+    WriteTask task;
+    task.exclusive = true;
+    task.apply = [this, path = std::move(path), onProgress = std::move(onProgress), onComplete = std::move(onComplete)](StorageConnection& db) {
+        std::ifstream input(path, std::ios::binary);
+        if (!input)
+        {
+            if (onComplete) onComplete(false, 0, "Cannot open " + path);
+            return false;
+        }
+        input.seekg(0, std::ios::end);
+        ImportProgress progress;
+        progress.totalBytes = static_cast<uint64_t>(input.tellg());
+        input.seekg(0, std::ios::beg);
+
+        sqlite3_stmt* stmt = db.Statement(kUpsertItemSql);
+        if (!stmt || !db.Exec("PRAGMA synchronous=OFF;") || !db.Exec("BEGIN IMMEDIATE;"))
+        {
+            if (onComplete) onComplete(false, 0, "Failed to start import transaction");
+            return false;
+        }
+
+        std::vector<std::string> chunkKeys;
+        chunkKeys.reserve(kImportBatch);
+        std::string stepError;
+        auto commitChunk = [&]() {
+            if (!db.Exec("COMMIT;"))
+            {
+                stepError = "Failed to commit import batch";
+                return false;
+            }
+            InvalidateImported(chunkKeys);
+            progress.imported += chunkKeys.size();
+            chunkKeys.clear();
+            auto position = input.tellg();
+            progress.bytesRead = position < 0 ? progress.totalBytes : static_cast<uint64_t>(position);
+            if (onProgress) onProgress(progress);
+            return true;
+        };
+
+        AsyncStorageDumpSax sax([&](std::string const& key, std::string const& value) {
+            sqlite3_reset(stmt);
+            sqlite3_bind_text(stmt, 1, key.c_str(), static_cast<int>(key.size()), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, value.c_str(), static_cast<int>(value.size()), SQLITE_STATIC);
+            if (sqlite3_step(stmt) != SQLITE_DONE)
+            {
+                stepError = std::string("Failed to insert '") + key + "': " + sqlite3_errmsg(db.Handle());
+                return false;
+            }
+            chunkKeys.push_back(key);
+            if (chunkKeys.size() >= kImportBatch)
+            {
+                return commitChunk() && db.Exec("BEGIN IMMEDIATE;");
+            }
+            return true;
+        });
+
+        bool ok = nlohmann::json::sax_parse(input, &sax);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        if (ok)
+        {
+            progress.bytesRead = progress.totalBytes;
+            ok = commitChunk();
+        }
+        if (!ok && !sqlite3_get_autocommit(db.Handle()))
+        {
+            // Batches committed so far are kept; only the partial one is undone.
+            // A COMMIT that failed with SQLITE_BUSY leaves it open as well.
+            db.Exec("ROLLBACK;");
+        }
+        db.Exec("PRAGMA synchronous=NORMAL;");
+
+        std::string error = !sax.Error().empty() ? sax.Error() : stepError;
+        if (onComplete) onComplete(ok, progress.imported, error);
+        return ok;
+    };
+    Enqueue(std::move(task));
+}
+
+void StorageCore::EnableSearchIndex(std::string prefix) noexcept
+{
+    WriteTask task;
+    task.apply = [prefix = std::move(prefix)](StorageConnection& db) {
+        // Backfill before registering the prefix so rows are indexed once.
+        return db.Exec(kSearchSchemaSql) &&
+               StepWithText(db, kIndexPrefixSql, prefix, "enableSearchIndex: Failed to index prefix") &&
+               StepWithText(db, kInsertPrefixSql, prefix, "enableSearchIndex: Failed to register prefix");
+    };
+    Enqueue(std::move(task));
+}
+
+void StorageCore::DisableSearchIndex(std::string prefix) noexcept
+{
+    WriteTask task;
+    task.apply = [prefix = std::move(prefix)](StorageConnection& db) {
+        if (!db.Exec(kSearchSchemaSql) ||
+            !StepWithText(db, kDeletePrefixSql, prefix, "disableSearchIndex: Failed to remove prefix"))
+        {
+            return false;
+        }
+        // Only rows of a registered prefix were ever indexed; an FTS5 'delete'
+        // for anything else corrupts the external-content index.
+        if (sqlite3_changes(db.Handle()) == 0)
+        {
+            return true;
+        }
+        // Unregistered first so rows still covered by another prefix are kept.
+        return StepWithText(db, kUnindexPrefixSql, prefix, "disableSearchIndex: Failed to unindex prefix");
+    };
+    Enqueue(std::move(task));
+}
+
+void StorageCore::Search(std::string prefix, std::string query, int limit, SearchCallback onResult) noexcept
+{
+    std::string ftsQuery = ToFtsQuery(query);
+    if (ftsQuery.empty() || limit <= 0)
+    {
+        if (onResult) onResult({});
+        return;
+    }
+
+    // The index is maintained by the writer, so searching in its queue sees
+    // every earlier write without blocking the caller on a Flush.
+    WriteTask task;
+    task.exclusive = true;
+    task.apply = [prefix = std::move(prefix), ftsQuery = std::move(ftsQuery), limit, onResult = std::move(onResult)](StorageConnection& db) {
+        auto keys = RunSearch(db, ftsQuery, prefix, limit);
+        if (onResult) onResult(std::move(keys));
+        return true;
+    };
+    Enqueue(std::move(task));
+}
+
+std::optional<StorageCore::StoredNumber> StorageCore::ReadNumber(std::string const& key) noexcept
+{
+    auto connection = m_readers.Take();
+    if (!connection) return std::nullopt;
+
+    std::optional<StoredNumber> result = std::nullopt;
+    if (sqlite3_stmt* stmt = connection->Statement(kSelectNumberSql))
+    {
+        sqlite3_bind_text(stmt, 1, key.c_str(), static_cast<int>(key.size()), SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW)
+        {
+            switch (sqlite3_column_type(stmt, 0))
+            {
+            case SQLITE_INTEGER:
+                result = static_cast<int64_t>(sqlite3_column_int64(stmt, 0));
+                break;
+            case SQLITE_FLOAT:
+                result = sqlite3_column_double(stmt, 0);
+                break;
+            default:
+                break;
+            }
+        }
+        else if (rc != SQLITE_DONE)
+        {
+            LogSqliteError("getNumber: Failed to execute statement", connection->Handle());
+        }
+        sqlite3_reset(stmt);
+    }
+    m_readers.Return(std::move(connection));
+    return result;
+}
+
+void StorageCore::SetNumberLocked(std::string key, StoredNumber value) noexcept
+{
+    ++m_numbers.Put(key, value).pendingWrites;
+    ++m_writeEpoch;
+    EnforceCacheBudgetLocked();
+
+    WriteTask task;
+    task.key = key;
+    task.touchesNumbers = true;
+    task.apply = [key = std::move(key), value](StorageConnection& db) {
+        sqlite3_stmt* stmt = db.Statement(kUpsertNumberSql);
+        if (!stmt) return false;
+        sqlite3_bind_text(stmt, 1, key.c_str(), static_cast<int>(key.size()), SQLITE_STATIC);
+        if (auto integer = std::get_if<int64_t>(&value))
+        {
+            sqlite3_bind_int64(stmt, 2, *integer);
+        }
+        else
+        {
+            sqlite3_bind_double(stmt, 2, std::get<double>(value));
+        }
+        bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+        if (!ok) LogSqliteError("setNumber: Failed to execute statement", db.Handle());
+        sqlite3_reset(stmt);
+        return ok;
+    };
+    Enqueue(std::move(task));
+}
+
+void StorageCore::SetNumber(std::string key, StoredNumber value) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    SetNumberLocked(std::move(key), value);
+}
+
+std::optional<StorageCore::StoredNumber> StorageCore::GetNumber(std::string const& key) noexcept
+{
+    uint64_t epoch = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        if (auto* entry = m_numbers.Find(key))
+        {
+            return entry->value;
+        }
+        if (m_pendingClears > 0)
+        {
+            return std::nullopt;
+        }
+        epoch = m_writeEpoch;
+    }
+
+    auto value = ReadNumber(key);
+
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    if (epoch == m_writeEpoch)
+    {
+        m_numbers.Put(key, value);
+        EnforceCacheBudgetLocked();
+    }
+    return value;
+}
+
+std::optional<int64_t> StorageCore::ExactInt64(double value) noexcept
+{
+    // 2^63 is exact as a double; INT64_MAX is not.
+    if (!std::isfinite(value) || value != std::trunc(value) || value < -9223372036854775808.0 || value >= 9223372036854775808.0)
+    {
+        return std::nullopt;
+    }
+    return static_cast<int64_t>(value);
+}
+
+std::optional<int64_t> StorageCore::IncrementInt64(std::string key, int64_t delta) noexcept
+{
+    // Missing counts as 0; a REAL only if it is a whole int64. No wrapping.
+    auto add = [delta](std::optional<StoredNumber> const& value) -> std::optional<int64_t> {
+        int64_t current = 0;
+        if (value)
+        {
+            auto integer = std::visit([](auto v) -> std::optional<int64_t> {
+                if constexpr (std::is_same_v<decltype(v), int64_t>) return v;
+                else return ExactInt64(v);
+            }, *value);
+            if (!integer) return std::nullopt;
+            current = *integer;
+        }
+        if ((delta > 0 && current > INT64_MAX - delta) || (delta < 0 && current < INT64_MIN - delta))
+        {
+            return std::nullopt;
+        }
+        return current + delta;
+    };
+
+    while (true)
+    {
+        uint64_t epoch = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_cacheMutex);
+            auto* entry = m_numbers.Find(key);
+            if (entry || m_pendingClears > 0)
+            {
+                auto next = add(entry ? entry->value : std::nullopt);
+                if (next) SetNumberLocked(std::move(key), *next);
+                return next;
+            }
+            epoch = m_writeEpoch;
+        }
+
+        // Not cached: read outside the lock, then read-modify-write under it
+        // unless another write got in first.
+        auto current = ReadNumber(key);
+
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        if (epoch == m_writeEpoch)
+        {
+            auto next = add(current);
+            if (next) SetNumberLocked(std::move(key), *next);
+            return next;
+        }
+    }
+}
+
+} // namespace winrt::ReactLocalStorage
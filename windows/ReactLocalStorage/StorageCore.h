@@ -0,0 +1,322 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "MemoryGovernor.h"
+
+// Forward declare sqlite3
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace winrt::ReactLocalStorage
+{
+
+// A single SQLite connection plus the statements prepared on it.
+// Statements are prepared once and reused; Statement() hands them back reset.
+class StorageConnection
+{
+public:
+  StorageConnection() = default;
+  ~StorageConnection();
+
+  StorageConnection(StorageConnection const&) = delete;
+  StorageConnection& operator=(StorageConnection const&) = delete;
+
+  bool Open(std::string const& path, bool readOnly) noexcept;
+  void Close() noexcept;
+
+  sqlite3* Handle() const noexcept { return m_db; }
+
+  // Returns a cached prepared statement for |sql|, or nullptr on failure.
+  // |sql| must be a string literal: the cache is keyed by its address.
+  sqlite3_stmt* Statement(const char* sql) noexcept;
+
+  bool Exec(const char* sql) noexcept;
+
+  // Applies PRAGMA cache_size if it differs from what is already set.
+  void SetPageCacheKiB(int kib) noexcept;
+
+private:
+  sqlite3* m_db{nullptr};
+  int m_pageCacheKiB{0};
+  std::unordered_map<const char*, sqlite3_stmt*> m_statements;
+};
+
+// Process-wide storage shared by every ReactLocalStorage module instance that
+// points at the same database file. Owns one writer connection driven by a
+// single writer thread, a small pool of reader connections and one item cache.
+//
+// Writes are applied to the cache immediately and committed asynchronously in
+// batches by the writer thread, so reads always observe the latest write.
+// A write that still can't be committed after retrying is dropped from the
+// cache again, so later reads fall through to what the database holds.
+//
+// Numbers and booleans live in their own table using SQLite's native INTEGER
+// and REAL storage classes. removeItem and clear apply to both tables.
+//
+// The caches are LRU-bounded by the MemoryGovernor budget; entries with
+// uncommitted writes are never evicted.
+class StorageCore : public MemoryConsumer
+{
+public:
+  using StoredNumber = std::variant<int64_t, double>;
+
+  // Returns the core for |dbPath|, opening it on first use. The core stays
+  // alive as long as at least one caller holds the returned pointer.
+  static std::shared_ptr<StorageCore> Acquire(std::string const& dbPath) noexcept;
+
+  ~StorageCore();
+
+  StorageCore(StorageCore const&) = delete;
+  StorageCore& operator=(StorageCore const&) = delete;
+
+  std::string const& Path() const noexcept { return m_path; }
+
+  void SetItem(std::string key, std::string value) noexcept;
+  std::optional<std::string> GetItem(std::string const& key) noexcept;
+  void RemoveItem(std::string key) noexcept;
+  void Clear() noexcept;
+
+  void SetNumber(std::string key, StoredNumber value) noexcept;
+  std::optional<StoredNumber> GetNumber(std::string const& key) noexcept;
+
+  // Adds |delta| to the integer stored at |key| (missing counts as 0) and
+  // returns the new value. Atomic with respect to every user of this core.
+  // Returns nullopt and leaves the value alone if it isn't an integer (see
+  // ExactInt64) or the sum would overflow int64.
+  std::optional<int64_t> IncrementInt64(std::string key, int64_t delta) noexcept;
+
+  // |value| as an int64 if it is a whole number inside the int64 range.
+  static std::optional<int64_t> ExactInt64(double value) noexcept;
+
+  // Opt-in full-text index over key_value_store. Items whose key starts with
+  // an enabled prefix are mirrored into an FTS5 table by triggers. Disabling
+  // a prefix that isn't enabled does nothing.
+  void EnableSearchIndex(std::string prefix) noexcept;
+  void DisableSearchIndex(std::string prefix) noexcept;
+
+  using SearchCallback = std::function<void(std::vector<std::string> keys)>;
+
+  // Finds up to |limit| keys under |prefix| whose value matches every term
+  // of |query| (prefix match per term), best match first. Runs on the writer
+  // thread once every write queued before it is committed, so the caller
+  // never waits on the queue; |onResult| runs on the writer thread.
+  void Search(std::string prefix, std::string query, int limit, SearchCallback onResult) noexcept;
+
+  struct ImportProgress
+  {
+    uint64_t imported{0};
+    uint64_t bytesRead{0};
+    uint64_t totalBytes{0};
+  };
+  using ImportProgressCallback = std::function<void(ImportProgress const&)>;
+  using ImportCompleteCallback = std::function<void(bool ok, uint64_t imported, std::string const& error)>;
+
+  // Streams an AsyncStorage-style JSON object ({"key": "value", ...}) from
+  // the file at |path| into key_value_store on the writer thread. Entries are
+  // committed in large transactions with synchronous=OFF; non-string values
+  // are stored as their JSON text and nulls are skipped. Callbacks run on the
+  // writer thread.
+  void ImportJsonDump(std::string path, ImportProgressCallback onProgress, ImportCompleteCallback onComplete) noexcept;
+
+  // Blocks until every write queued so far has been committed.
+  void Flush() noexcept;
+
+  // MemoryConsumer
+  size_t MemoryUsage() noexcept override;
+  void TrimMemory(size_t targetBytes) noexcept override;
+
+private:
+  // Key -> value cache with LRU eviction and byte accounting. Not
+  // thread-safe; guarded by m_cacheMutex.
+  template <typename T>
+  class ItemCache
+  {
+  public:
+    struct Entry
+    {
+      std::optional<T> value;    // nullopt caches a missing key
+      uint32_t pendingWrites{0}; // queued writes not yet committed
+      size_t bytes{0};
+      typename std::list<std::string const*>::iterator lruPos;
+    };
+
+    // Returns the entry for |key| and marks it most recently used.
+    Entry* Find(std::string const& key)
+    {
+      auto it = m_entries.find(key);
+      if (it == m_entries.end()) return nullptr;
+      m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+      return &it->second;
+    }
+
+    // Stores |value| for |key|, creating the entry if needed.
+    Entry& Put(std::string const& key, std::optional<T> value)
+    {
+      auto [it, inserted] = m_entries.try_emplace(key);
+      Entry& entry = it->second;
+      if (inserted)
+      {
+        m_lru.push_front(&it->first);
+        entry.lruPos = m_lru.begin();
+      }
+      else
+      {
+        m_lru.splice(m_lru.begin(), m_lru, entry.lruPos);
+        m_bytes -= entry.bytes;
+      }
+      entry.value = std::move(value);
+      entry.bytes = key.size() + ValueBytes(entry.value) + kEntryOverhead;
+      m_bytes += entry.bytes;
+      return entry;
+    }
+
+    void Release(std::string const& key)
+    {
+      auto it = m_entries.find(key);
+      if (it != m_entries.end() && it->second.pendingWrites > 0)
+      {
+        --it->second.pendingWrites;
+      }
+    }
+
+    // Like Release, for a write that never reached the database: once no
+    // other write is queued the entry no longer matches it and is dropped.
+    void Discard(std::string const& key)
+    {
+      auto it = m_entries.find(key);
+      if (it == m_entries.end()) return;
+      if (it->second.pendingWrites > 0) --it->second.pendingWrites;
+      if (it->second.pendingWrites == 0) Erase(it);
+    }
+
+    void EraseIfIdle(std::string const& key)
+    {
+      auto it = m_entries.find(key);
+      if (it != m_entries.end() && it->second.pendingWrites == 0)
+      {
+        Erase(it);
+      }
+    }
+
+    // Evicts least recently used idle entries until Bytes() <= |targetBytes|.
+    void Trim(size_t targetBytes)
+    {
+      auto pos = m_lru.end();
+      while (m_bytes > targetBytes && pos != m_lru.begin())
+      {
+        --pos;
+        auto it = m_entries.find(**pos);
+        if (it->second.pendingWrites > 0) continue;
+        pos = std::next(pos);
+        Erase(it);
+      }
+    }
+
+    void Clear()
+    {
+      m_entries.clear();
+      m_lru.clear();
+      m_bytes = 0;
+    }
+
+    size_t Bytes() const { return m_bytes; }
+
+  private:
+    static constexpr size_t kEntryOverhead = 64;
+    static size_t ValueBytes(std::optional<std::string> const& value) { return value ? value->size() : 0; }
+    template <typename U>
+    static size_t ValueBytes(std::optional<U> const&) { return sizeof(U); }
+
+    void Erase(typename std::unordered_map<std::string, Entry>::iterator it)
+    {
+      m_bytes -= it->second.bytes;
+      m_lru.erase(it->second.lruPos);
+      m_entries.erase(it);
+    }
+
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string const*> m_lru; // front = most recently used
+    size_t m_bytes{0};
+  };
+
+  struct WriteTask
+  {
+    std::function<bool(StorageConnection&)> apply;
+    std::optional<std::string> key; // cache key to release after commit
+    bool touchesItems{false};
+    bool touchesNumbers{false};
+    bool isClear{false};
+    bool exclusive{false}; // runs alone and manages its own transactions
+  };
+
+  // Fixed-size pool of read-only connections, opened lazily.
+  class ReaderPool
+  {
+  public:
+    explicit ReaderPool(std::string path) : m_path(std::move(path)) {}
+    std::unique_ptr<StorageConnection> Take() noexcept;
+    void Return(std::unique_ptr<StorageConnection> connection) noexcept;
+    void CloseAll() noexcept;
+
+  private:
+    static constexpr size_t kMaxReaders = 4;
+    std::string m_path;
+    std::mutex m_mutex;
+    std::condition_variable m_available;
+    std::vector<std::unique_ptr<StorageConnection>> m_idle;
+    size_t m_opened{0};
+  };
+
+  explicit StorageCore(std::string path);
+
+  bool Open() noexcept;
+  void Close() noexcept;
+
+  void Enqueue(WriteTask task) noexcept;
+  void WriterLoop() noexcept;
+  bool CommitBatch(std::vector<WriteTask>& batch, std::vector<bool>& applied) noexcept;
+  void ReleaseBatch(std::vector<WriteTask> const& batch, std::vector<bool> const& committed) noexcept;
+  void InvalidateImported(std::vector<std::string> const& keys) noexcept;
+
+  std::optional<std::string> ReadItem(std::string const& key) noexcept;
+  std::optional<StoredNumber> ReadNumber(std::string const& key) noexcept;
+  void SetNumberLocked(std::string key, StoredNumber value) noexcept;
+  void EnforceCacheBudgetLocked() noexcept;
+
+  std::string m_path;
+
+  // Writer side
+  StorageConnection m_writer;
+  std::thread m_writerThread;
+  std::mutex m_queueMutex;
+  std::condition_variable m_queueChanged;
+  std::deque<WriteTask> m_queue;
+  bool m_writerBusy{false};
+  bool m_stopping{false};
+
+  // Reader side
+  ReaderPool m_readers;
+
+  // Cache
+  std::mutex m_cacheMutex;
+  ItemCache<std::string> m_cache;
+  ItemCache<StoredNumber> m_numbers;
+  uint32_t m_pendingClears{0};
+  uint64_t m_writeEpoch{0}; // bumped by every mutation, guards read-through fills
+};
+
+} // namespace winrt::ReactLocalStorage
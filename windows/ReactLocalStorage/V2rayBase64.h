@@ -0,0 +1,391 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define V2RAY_BASE64_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSSE3/AVX2 instructions inside functions that opt in.
+#if defined(V2RAY_BASE64_X86) && (defined(__GNUC__) || defined(__clang__))
+#define V2RAY_BASE64_TARGET(isa) __attribute__((target(isa)))
+#else
+#define V2RAY_BASE64_TARGET(isa)
+#endif
+
+// =================================================================================
+// Base64 decoding for share links and subscriptions
+// =================================================================================
+namespace V2rayConfigWin
+{
+    namespace Utils
+    {
+        enum class Base64Alphabet {
+            Standard, // A-Z a-z 0-9 + /
+            UrlSafe,  // A-Z a-z 0-9 - _
+            Any,      // either of the above, as found in the wild
+        };
+
+        enum class Base64Error {
+            None = 0,
+            InvalidCharacter, // byte outside the alphabet
+            InvalidPadding,   // '=' in the wrong place or followed by data
+            TruncatedInput,   // a single dangling character in the last quantum
+        };
+
+        struct Base64DecodeResult {
+            Base64Error error = Base64Error::None;
+            size_t offset = 0; // input offset of the offending byte
+            explicit operator bool() const { return error == Base64Error::None; }
+        };
+
+        namespace detail
+        {
+            constexpr uint8_t kBase64Invalid = 0xFF;
+            constexpr uint8_t kBase64Space = 0xFE;
+
+            constexpr std::array<uint8_t, 256> make_base64_table(Base64Alphabet alphabet) {
+                std::array<uint8_t, 256> table{};
+                for (auto& v : table) v = kBase64Invalid;
+                constexpr const char* core = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+                for (uint8_t i = 0; i < 62; ++i) table[static_cast<uint8_t>(core[i])] = i;
+                if (alphabet != Base64Alphabet::UrlSafe) { table['+'] = 62; table['/'] = 63; }
+                if (alphabet != Base64Alphabet::Standard) { table['-'] = 62; table['_'] = 63; }
+                table[' '] = table['\t'] = table['\r'] = table['\n'] = kBase64Space;
+                return table;
+            }
+
+            inline const std::array<uint8_t, 256>& base64_table(Base64Alphabet alphabet) {
+                static constexpr auto standard = make_base64_table(Base64Alphabet::Standard);
+                static constexpr auto urlSafe = make_base64_table(Base64Alphabet::UrlSafe);
+                static constexpr auto any = make_base64_table(Base64Alphabet::Any);
+                switch (alphabet) {
+                case Base64Alphabet::Standard: return standard;
+                case Base64Alphabet::UrlSafe: return urlSafe;
+                default: return any;
+                }
+            }
+
+#if defined(V2RAY_BASE64_X86)
+            struct CpuFeatures {
+                bool ssse3 = false;
+                bool avx2 = false;
+            };
+
+            inline CpuFeatures detect_cpu_features() {
+                CpuFeatures features;
+#if defined(_MSC_VER) && !defined(__clang__)
+                int info[4] = {};
+                __cpuid(info, 0);
+                int maxLeaf = info[0];
+                __cpuid(info, 1);
+                features.ssse3 = (info[2] & (1 << 9)) != 0;
+                bool osxsave = (info[2] & (1 << 27)) != 0;
+                bool avx = (info[2] & (1 << 28)) != 0;
+                if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+                    __cpuidex(info, 7, 0);
+                    features.avx2 = (info[1] & (1 << 5)) != 0;
+                }
+#else
+                __builtin_cpu_init();
+                features.ssse3 = __builtin_cpu_supports("ssse3");
+                features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+                return features;
+            }
+
+            inline const CpuFeatures& cpu_features() {
+                static const CpuFeatures features = detect_cpu_features();
+                return features;
+            }
+
+            // Nibble lookup tables (Mula/Lemire): a byte is invalid when
+            // lo[c & 0xF] & hi[c >> 4] != 0, and decodes to c + roll[idx] where idx is
+            // the high nibble, shifted by |specialDelta| for the one character that
+            // shares its high nibble with letters.
+            struct SimdAlphabet {
+                int8_t lo[16];
+                int8_t hi[16];
+                int8_t roll[16];
+                char special;
+                int8_t specialDelta;
+            };
+
+            constexpr SimdAlphabet kSimdStandard = {
+                { 0x0B, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x07, 0x15, 0x17, 0x17, 0x17, 0x15 },
+                { 0x01, 0x01, 0x02, 0x04, 0x08, 0x10, 0x08, 0x10, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01 },
+                { 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 },
+                '/', -1,
+            };
+
+            constexpr SimdAlphabet kSimdUrlSafe = {
+                { 0x0B, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x07, 0x37, 0x37, 0x35, 0x37, 0x27 },
+                { 0x01, 0x01, 0x02, 0x04, 0x08, 0x10, 0x08, 0x20, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01 },
+                { 0, 0, 17, 4, -65, -65, -71, -71, -32, 0, 0, 0, 0, 0, 0, 0 },
+                '_', 3,
+            };
+
+            // Decodes 16 characters into 12 bytes (16 are stored). Returns false,
+            // writing nothing, if any character is outside |a|.
+            V2RAY_BASE64_TARGET("ssse3")
+            inline bool decode_block_ssse3(const char* src, uint8_t* dst, const SimdAlphabet& a) {
+                const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(input, 4), _mm_set1_epi8(0x0F));
+                const __m128i loNibbles = _mm_and_si128(input, _mm_set1_epi8(0x0F));
+                const __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.lo)), loNibbles);
+                const __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.hi)), hiNibbles);
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF) {
+                    return false;
+                }
+                const __m128i isSpecial = _mm_cmpeq_epi8(input, _mm_set1_epi8(a.special));
+                const __m128i rollIndex = _mm_add_epi8(hiNibbles, _mm_and_si128(isSpecial, _mm_set1_epi8(a.specialDelta)));
+                const __m128i roll = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.roll)), rollIndex);
+                const __m128i values = _mm_add_epi8(input, roll);
+
+                // Pack 4 x 6 bits into 3 bytes per 32-bit lane, then squeeze out the gaps.
+                const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+                const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+                const __m128i packed = _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), packed);
+                return true;
+            }
+
+            // Decodes 32 characters into 24 bytes (32 are stored).
+            V2RAY_BASE64_TARGET("avx2")
+            inline bool decode_block_avx2(const char* src, uint8_t* dst, const SimdAlphabet& a) {
+                const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+                const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(input, 4), _mm256_set1_epi8(0x0F));
+                const __m256i loNibbles = _mm256_and_si256(input, _mm256_set1_epi8(0x0F));
+                const __m256i lutLo = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.lo)));
+                const __m256i lutHi = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.hi)));
+                const __m256i lutRoll = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a.roll)));
+                const __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+                const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+                if (!_mm256_testz_si256(lo, hi)) {
+                    return false;
+                }
+                const __m256i isSpecial = _mm256_cmpeq_epi8(input, _mm256_set1_epi8(a.special));
+                const __m256i rollIndex = _mm256_add_epi8(hiNibbles, _mm256_and_si256(isSpecial, _mm256_set1_epi8(a.specialDelta)));
+                const __m256i values = _mm256_add_epi8(input, _mm256_shuffle_epi8(lutRoll, rollIndex));
+
+                const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+                const __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+                const __m256i lanes = _mm256_shuffle_epi8(quads, _mm256_setr_epi8(
+                    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+                const __m256i packed = _mm256_permutevar8x32_epi32(lanes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), packed);
+                return true;
+            }
+#endif
+        } // namespace detail
+
+        // Decodes |in| and appends the bytes to |out|. Padding is optional but must
+        // be correct when present; ASCII whitespace (line-wrapped subscriptions) is
+        // skipped. On failure |out| keeps whatever was decoded before the error.
+        //
+        // Runs of 32 (AVX2) or 16 (SSSE3) characters are decoded with SIMD when
+        // the CPU supports it; whitespace, padding and tails go through the table.
+        inline Base64DecodeResult decode_base64(std::string_view in, std::string& out, Base64Alphabet alphabet = Base64Alphabet::Any) {
+            const auto& table = detail::base64_table(alphabet);
+            const size_t base = out.size();
+            // Slack lets the SIMD stores write a full register past the last triple.
+            out.resize(base + in.size() / 4 * 3 + 3 + 32);
+            uint8_t* dst = reinterpret_cast<uint8_t*>(out.data()) + base;
+            uint8_t* const dstBegin = dst;
+
+            auto finish = [&](Base64DecodeResult result) {
+                out.resize(base + (dst - dstBegin));
+                return result;
+            };
+
+#if defined(V2RAY_BASE64_X86)
+            const auto& cpu = detail::cpu_features();
+            const detail::SimdAlphabet* simdPrimary = alphabet == Base64Alphabet::UrlSafe ? &detail::kSimdUrlSafe : &detail::kSimdStandard;
+            const detail::SimdAlphabet* simdSecondary = alphabet == Base64Alphabet::Any ? &detail::kSimdUrlSafe : nullptr;
+#endif
+
+            uint32_t acc = 0;
+            int quantum = 0; // characters in the current 4-character group
+            size_t i = 0;
+            const size_t n = in.size();
+            while (i < n) {
+#if defined(V2RAY_BASE64_X86)
+                if (quantum == 0) {
+                    if (cpu.avx2 && n - i >= 32) {
+                        if (detail::decode_block_avx2(in.data() + i, dst, *simdPrimary) ||
+                            (simdSecondary && detail::decode_block_avx2(in.data() + i, dst, *simdSecondary))) {
+                            i += 32;
+                            dst += 24;
+                            continue;
+                        }
+                    } else if (cpu.ssse3 && n - i >= 16) {
+                        if (detail::decode_block_ssse3(in.data() + i, dst, *simdPrimary) ||
+                            (simdSecondary && detail::decode_block_ssse3(in.data() + i, dst, *simdSecondary))) {
+                            i += 16;
+                            dst += 12;
+                            continue;
+                        }
+                    }
+                }
+#endif
+                // Scalar: consume one group (or until an '=' / error), then retry SIMD.
+                do {
+                    const uint8_t c = static_cast<uint8_t>(in[i]);
+                    const uint8_t v = table[c];
+                    if (v < 64) {
+                        acc = (acc << 6) | v;
+                        if (++quantum == 4) {
+                            *dst++ = static_cast<uint8_t>(acc >> 16);
+                            *dst++ = static_cast<uint8_t>(acc >> 8);
+                            *dst++ = static_cast<uint8_t>(acc);
+                            acc = 0;
+                            quantum = 0;
+                        }
+                    } else if (v == detail::kBase64Space) {
+                        // skip
+                    } else if (c == '=') {
+                        if (quantum < 2) {
+                            return finish({ Base64Error::InvalidPadding, i });
+                        }
+                        int pads = 0;
+                        for (; i < n; ++i) {
+                            const uint8_t p = static_cast<uint8_t>(in[i]);
+                            if (p == '=') {
+                                if (++pads > 4 - quantum) return finish({ Base64Error::InvalidPadding, i });
+                            } else if (table[p] != detail::kBase64Space) {
+                                return finish({ Base64Error::InvalidPadding, i });
+                            }
+                        }
+                        if (pads != 4 - quantum) {
+                            return finish({ Base64Error::InvalidPadding, n });
+                        }
+                        break;
+                    } else {
+                        return finish({ Base64Error::InvalidCharacter, i });
+                    }
+                    ++i;
+                } while (i < n && quantum != 0);
+            }
+
+            if (quantum == 1) {
+                return finish({ Base64Error::TruncatedInput, n });
+            }
+            if (quantum == 2) {
+                *dst++ = static_cast<uint8_t>(acc >> 4);
+            } else if (quantum == 3) {
+                *dst++ = static_cast<uint8_t>(acc >> 10);
+                *dst++ = static_cast<uint8_t>(acc >> 2);
+            }
+            return finish({});
+        }
+
+        // Incremental form of decode_base64 for input that arrives in pieces.
+        // Each push() decodes every complete 4-character group seen so far and
+        // carries at most three characters over to the next call, so memory use
+        // is bounded by the chunk size rather than the whole payload. Offsets in
+        // errors are relative to the start of the stream. After an error every
+        // further call returns the same error.
+        class Base64StreamDecoder {
+        public:
+            explicit Base64StreamDecoder(Base64Alphabet alphabet = Base64Alphabet::Any) : m_alphabet(alphabet) {}
+
+            Base64DecodeResult push(std::string_view chunk, std::string& out) {
+                if (!m_error) return m_error;
+                const auto& table = detail::base64_table(m_alphabet);
+                auto is_space = [&table](char c) { return table[static_cast<uint8_t>(c)] == detail::kBase64Space; };
+                const size_t base = m_offset;
+                m_offset += chunk.size();
+                const size_t n = chunk.size();
+                size_t i = 0;
+
+                // Complete the group carried over from the previous chunk.
+                while (m_carrySize > 0 && m_carrySize < 4 && i < n) {
+                    if (!is_space(chunk[i])) carry(chunk[i], base + i);
+                    ++i;
+                }
+                if (m_carrySize == 4) {
+                    if (auto result = decode_carry(out); !result) return result;
+                }
+
+                // Once a padded group has been decoded only whitespace may follow.
+                if (m_padded) {
+                    for (; i < n; ++i) {
+                        if (!is_space(chunk[i])) return fail(Base64Error::InvalidPadding, base + i);
+                    }
+                    return {};
+                }
+
+                // Decode the longest prefix holding whole groups; keep the rest.
+                size_t significant = 0;
+                for (size_t k = i; k < n; ++k) significant += !is_space(chunk[k]);
+                size_t cut = n;
+                for (size_t keep = significant % 4; keep > 0; ) {
+                    if (!is_space(chunk[--cut])) --keep;
+                }
+
+                const std::string_view body = chunk.substr(i, cut - i);
+                if (auto result = decode_base64(body, out, m_alphabet); !result) {
+                    return fail(result.error, base + i + result.offset);
+                }
+                size_t last = body.size();
+                while (last > 0 && is_space(body[last - 1])) --last;
+                m_padded = last > 0 && body[last - 1] == '=';
+
+                for (size_t k = cut; k < n; ++k) {
+                    if (is_space(chunk[k])) continue;
+                    if (m_padded) return fail(Base64Error::InvalidPadding, base + k);
+                    carry(chunk[k], base + k);
+                }
+                return {};
+            }
+
+            // Decodes the final partial group, if any.
+            Base64DecodeResult finish(std::string& out) {
+                if (!m_error || m_carrySize == 0) return m_error;
+                return decode_carry(out);
+            }
+
+            size_t bytesConsumed() const { return m_offset; }
+
+        private:
+            void carry(char c, size_t offset) {
+                m_carryOffset[m_carrySize] = offset;
+                m_carry[m_carrySize++] = c;
+            }
+
+            Base64DecodeResult decode_carry(std::string& out) {
+                const std::string_view group(m_carry, m_carrySize);
+                m_carrySize = 0;
+                if (auto result = decode_base64(group, out, m_alphabet); !result) {
+                    // An offset past the group means "missing padding": report the end.
+                    return fail(result.error, result.offset < group.size() ? m_carryOffset[result.offset] : m_offset);
+                }
+                m_padded = group.back() == '=';
+                return {};
+            }
+
+            Base64DecodeResult fail(Base64Error error, size_t offset) {
+                m_error = { error, offset };
+                return m_error;
+            }
+
+            Base64Alphabet m_alphabet;
+            char m_carry[4] = {};
+            size_t m_carrySize = 0;
+            size_t m_carryOffset[4] = {}; // stream offset of each carried character
+            size_t m_offset = 0;      // bytes pushed so far
+            bool m_padded = false;
+            Base64DecodeResult m_error;
+        };
+    } // namespace Utils
+} // namespace V2rayConfigWin
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "V2rayConfigWin.h"
+#include "V2rayServerTable.h"
+
+// =================================================================================
+// Generated config cache
+// =================================================================================
+namespace V2rayConfigWin
+{
+    // Identifies one generate() output: what the server contributes (its
+    // outbound as written into the config) and every setting that shapes the
+    // rest of the document.
+    struct ConfigCacheKey {
+        ServerFingerprint server;
+        ServerFingerprint settings;
+
+        bool operator==(const ConfigCacheKey& other) const { return server == other.server && settings == other.settings; }
+        bool operator!=(const ConfigCacheKey& other) const { return !(*this == other); }
+    };
+
+    struct ConfigCacheKeyHash {
+        size_t operator()(const ConfigCacheKey& key) const noexcept {
+            return static_cast<size_t>(key.server.low ^ (key.settings.low * 0x9e3779b97f4a7c15ULL));
+        }
+    };
+
+    // Stable text form of every V2rayGeneratorSettings field, one
+    // "name=<length>:value" line each, in declaration order. The geo catalog
+    // contributes its fingerprint rather than its address.
+    inline std::string canonical_form(const V2rayGeneratorSettings& settings) {
+        std::string out;
+        out.reserve(256 + settings.userRoutingAgent.size() + settings.userRoutingDirect.size() + settings.userRoutingBlocked.size());
+        auto field = [&out](std::string_view name, std::string_view value) {
+            out += name;
+            out += '=';
+            out += std::to_string(value.size());
+            out += ':';
+            out += value;
+            out += '\n';
+        };
+        auto flag = [&field](std::string_view name, bool value) { field(name, value ? "1" : "0"); };
+        field("logLevel", settings.logLevel);
+        field("socksPort", std::to_string(settings.socksPort));
+        field("httpPort", std::to_string(settings.httpPort));
+        field("localDnsPort", std::to_string(settings.localDnsPort));
+        flag("proxySharing", settings.proxySharing);
+        flag("fakeDnsEnabled", settings.fakeDnsEnabled);
+        flag("sniffingEnabled", settings.sniffingEnabled);
+        flag("localDnsEnabled", settings.localDnsEnabled);
+        flag("speedEnabled", settings.speedEnabled);
+        field("routingDomainStrategy", settings.routingDomainStrategy);
+        field("routingMode", std::to_string(static_cast<int>(settings.routingMode)));
+        field("userRoutingAgent", settings.userRoutingAgent);
+        field("userRoutingDirect", settings.userRoutingDirect);
+        field("userRoutingBlocked", settings.userRoutingBlocked);
+        flag("prettyPrint", settings.prettyPrint);
+        field("geoCatalog", settings.geoCatalog ? std::to_string(settings.geoCatalog->fingerprint()) : "");
+        return out;
+    }
+
+    inline ServerFingerprint settings_fingerprint(const V2rayGeneratorSettings& settings) {
+        return Utils::murmur3_128(canonical_form(settings));
+    }
+
+    // Keeps the most recently generated configs, keyed by ConfigCacheKey, so
+    // switching back to a recent server skips generate(). Least recently used
+    // entries are evicted past |capacity|. Not synchronized; callers share one
+    // instance behind their own lock.
+    class ConfigCache {
+    public:
+        // Bump whenever the file layout or what generate() produces changes; a
+        // file with any other version is ignored and rebuilt.
+        static constexpr uint32_t kFormatVersion = 2;
+        static constexpr char kMagic[4] = { 'V', '2', 'G', 'C' };
+
+        explicit ConfigCache(size_t capacity = 32) : m_capacity(capacity ? capacity : 1) {}
+
+        // Custom configs aren't produced by generate(), so they have no key.
+        static std::optional<ConfigCacheKey> key(const ServerConfig& server, const V2rayGeneratorSettings& settings) {
+            if (server.configType == EConfigType::CUSTOM) return std::nullopt;
+            std::string outbound;
+            JsonWriter writer(outbound);
+            if (server.outboundBean) V2rayConfig::write_outbound(writer, *server.outboundBean, AppConfigConstants::TAG_AGENT);
+            return ConfigCacheKey{ Utils::murmur3_128(outbound), settings_fingerprint(settings) };
+        }
+
+        std::optional<std::string> lookup(const ConfigCacheKey& key) {
+            auto it = m_index.find(key);
+            if (it == m_index.end()) {
+                ++m_misses;
+                return std::nullopt;
+            }
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            ++m_hits;
+            return it->second->config;
+        }
+
+        void store(const ConfigCacheKey& key, std::string config) {
+            if (auto it = m_index.find(key); it != m_index.end()) {
+                it->second->config = std::move(config);
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+            } else {
+                m_entries.push_front({ key, std::move(config) });
+                m_index.emplace(key, m_entries.begin());
+                while (m_entries.size() > m_capacity) {
+                    m_index.erase(m_entries.back().key);
+                    m_entries.pop_back();
+                }
+            }
+            m_dirty = true;
+        }
+
+        // The cached config for |server| under |settings|, generating and
+        // storing it on a miss. Returns nullopt only if generate() fails.
+        std::optional<std::string> generate(const ServerConfig& server, const V2rayGeneratorSettings& settings) {
+            const auto cacheKey = key(server, settings);
+            if (!cacheKey) return V2rayConfigGenerator::generate(server, settings);
+            if (auto cached = lookup(*cacheKey)) return cached;
+            auto config = V2rayConfigGenerator::generate(server, settings);
+            if (config) store(*cacheKey, *config);
+            return config;
+        }
+
+        size_t size() const { return m_entries.size(); }
+        size_t capacity() const { return m_capacity; }
+        size_t hits() const { return m_hits; }
+        size_t misses() const { return m_misses; }
+        bool dirty() const { return m_dirty; }
+
+        void clear() {
+            m_entries.clear();
+            m_index.clear();
+            m_dirty = false;
+        }
+
+        // Replaces the contents with the file at |path|. Any failure leaves the
+        // cache empty.
+        CacheFileResult load(const std::filesystem::path& path) {
+            clear();
+            std::unique_ptr<char[]> buffer;
+            size_t size = 0;
+            if (auto status = detail::read_cache_file(path, kMagic, kFormatVersion, buffer, size); status != CacheFileStatus::Ok) {
+                return CacheFileResult{ status, {} };
+            }
+
+            // Entries are stored most recent first.
+            detail::ByteReader in(buffer.get() + detail::kCacheHeaderSize, size - detail::kCacheHeaderSize);
+            uint32_t count = 0;
+            if (!in.read(count)) return CacheFileResult{ CacheFileStatus::Malformed, {} };
+            for (uint32_t i = 0; i < count; ++i) {
+                ConfigCacheKey key;
+                uint32_t length = 0;
+                if (!in.read(key.server.low) || !in.read(key.server.high) || !in.read(key.settings.low) ||
+                    !in.read(key.settings.high) || !in.read(length)) {
+                    clear();
+                    return CacheFileResult{ CacheFileStatus::Malformed, {} };
+                }
+                const char* text = in.take(length);
+                if (!text || m_index.count(key)) {
+                    clear();
+                    return CacheFileResult{ CacheFileStatus::Malformed, {} };
+                }
+                if (m_entries.size() == m_capacity) continue;
+                m_entries.push_back({ key, std::string(text, length) });
+                m_index.emplace(key, std::prev(m_entries.end()));
+            }
+            if (in.remaining() != 0) {
+                clear();
+                return CacheFileResult{ CacheFileStatus::Malformed, {} };
+            }
+            return {};
+        }
+
+        // Replaces the file at |path| atomically (see write_cache_file).
+        CacheFileResult save(const std::filesystem::path& path) {
+            std::string payload;
+            detail::put<uint32_t>(payload, static_cast<uint32_t>(m_entries.size()));
+            for (const auto& entry : m_entries) {
+                detail::put<uint64_t>(payload, entry.key.server.low);
+                detail::put<uint64_t>(payload, entry.key.server.high);
+                detail::put<uint64_t>(payload, entry.key.settings.low);
+                detail::put<uint64_t>(payload, entry.key.settings.high);
+                detail::put<uint32_t>(payload, static_cast<uint32_t>(entry.config.size()));
+                detail::put_bytes(payload, entry.config.data(), entry.config.size());
+            }
+
+            auto result = detail::write_cache_file(path, kMagic, kFormatVersion, payload);
+            if (result) m_dirty = false;
+            return result;
+        }
+
+    private:
+        struct Entry {
+            ConfigCacheKey key;
+            std::string config;
+        };
+
+        size_t m_capacity;
+        std::list<Entry> m_entries; // most recently used first
+        std::unordered_map<ConfigCacheKey, std::list<Entry>::iterator, ConfigCacheKeyHash> m_index;
+        size_t m_hits = 0;
+        size_t m_misses = 0;
+        bool m_dirty = false;
+    };
+}
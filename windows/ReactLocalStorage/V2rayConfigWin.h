@@ -1,16 +1,34 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <optional>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <cctype>
+#include <algorithm>
+#include <iterator>
+#include <system_error>
 #include <chrono>
 #include <map>
 #include <any>
 #include <stdexcept>
-#include <regex>
+#include <exception>
 #include <sstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include "V2rayBase64.h"
+#include "V2rayJsonWriter.h"
 namespace nlohmann {
     template <typename T>
     struct adl_serializer<std::optional<T>> {
@@ -41,38 +59,27 @@ namespace V2rayConfigWin
     // =================================================================================
     namespace Utils
     {
-        // WARNING: Basic Base64 decoder. REPLACE with a robust library for production.
-        inline std::string decode_base64(const std::string& in) {
-            std::string out;
-            std::vector<int> T(256, -1);
-            for (int i = 0; i < 64; i++) T["ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i]] = i;
-            int val = 0, valb = -8;
-            for (char c : in) {
-                if (c == '=') break;
-                if (T[c] == -1) continue;
-                val = (val << 6) + T[c];
-                valb += 6;
-                if (valb >= 0) {
-                    out.push_back(char((val >> valb) & 0xFF));
-                    valb -= 8;
-                }
-            }
-            return out;
+        inline int hex_digit_value(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
         }
 
-        // WARNING: Basic URL decoder. REPLACE with a robust library for production.
-        inline std::string url_decode(const std::string& in) {
+        // Percent-decodes |in| ('+' becomes a space). Malformed escapes are kept as-is.
+        inline std::string url_decode(std::string_view in) {
+            if (in.find_first_of("%+") == std::string_view::npos) {
+                return std::string(in);
+            }
             std::string out;
             out.reserve(in.length());
             for (std::size_t i = 0; i < in.length(); ++i) {
-                if (in[i] == '%') {
-                    if (i + 3 <= in.length()) {
-                        int value = 0;
-                        std::istringstream is(in.substr(i + 1, 2));
-                        if (is >> std::hex >> value) {
-                            out += static_cast<char>(value);
-                            i += 2;
-                        } else { out += '%'; }
+                if (in[i] == '%' && i + 2 < in.length()) {
+                    int hi = hex_digit_value(in[i + 1]);
+                    int lo = hex_digit_value(in[i + 2]);
+                    if (hi >= 0 && lo >= 0) {
+                        out += static_cast<char>((hi << 4) | lo);
+                        i += 2;
                     } else { out += '%'; }
                 } else if (in[i] == '+') {
                     out += ' ';
@@ -81,25 +88,105 @@ namespace V2rayConfigWin
             return out;
         }
 
-        inline int parse_int(const std::string& s, int default_val = 0) {
-            try {
-                return std::stoi(s);
-            } catch (...) {
+        inline int parse_int(std::string_view s, int default_val = 0) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+            int value = 0;
+            auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+            if (ec != std::errc() || ptr == s.data()) {
                 return default_val;
             }
+            return value;
         }
 
-        // A simple helper to split strings
-        inline std::vector<std::string> split(const std::string& s, char delimiter) {
+        // A simple helper to split strings. Like std::getline, a trailing
+        // delimiter doesn't produce an empty last token.
+        inline std::vector<std::string> split(std::string_view s, char delimiter) {
             std::vector<std::string> tokens;
-            std::string token;
-            std::istringstream tokenStream(s);
-            while (std::getline(tokenStream, token, delimiter)) {
-                tokens.push_back(token);
+            while (!s.empty()) {
+                const size_t at = s.find(delimiter);
+                tokens.emplace_back(s.substr(0, at));
+                if (at == std::string_view::npos) break;
+                s.remove_prefix(at + 1);
             }
             return tokens;
         }
 
+        // Non-owning view over "a=1&b=2". Lookups scan the query in place, which
+        // beats building a map for the handful of keys a share link carries.
+        // Values are only decoded (and allocated) when asked for.
+        class QueryParams {
+        public:
+            QueryParams() = default;
+            explicit QueryParams(std::string_view query) : m_query(query) {}
+
+            // Raw (still percent-encoded) value of |key|; the last occurrence wins.
+            std::optional<std::string_view> raw(std::string_view key) const {
+                std::optional<std::string_view> found;
+                std::string_view rest = m_query;
+                while (!rest.empty()) {
+                    size_t amp = rest.find('&');
+                    std::string_view pair = rest.substr(0, amp);
+                    rest = amp == std::string_view::npos ? std::string_view{} : rest.substr(amp + 1);
+                    size_t eq = pair.find('=');
+                    if (eq != std::string_view::npos && pair.substr(0, eq) == key) {
+                        found = pair.substr(eq + 1);
+                    }
+                }
+                return found;
+            }
+
+            bool contains(std::string_view key) const { return raw(key).has_value(); }
+
+            std::optional<std::string> get(std::string_view key) const {
+                if (auto value = raw(key)) return url_decode(*value);
+                return std::nullopt;
+            }
+
+            std::string get_or(std::string_view key, std::string_view fallback) const {
+                if (auto value = raw(key)) return url_decode(*value);
+                return std::string(fallback);
+            }
+
+        private:
+            std::string_view m_query;
+        };
+
+        // Components of "<userInfo>@<host>:<port>?<query>#<fragment>" with the
+        // scheme already stripped. Every member points into the parsed buffer.
+        struct ShareLinkView {
+            std::string_view userInfo;
+            std::string_view host;
+            std::string_view port;
+            std::string_view query;
+            std::string_view fragment;
+            bool hasUserInfo = false;
+        };
+
+        inline ShareLinkView split_share_link(std::string_view body) {
+            ShareLinkView view;
+            if (size_t pos = body.find('#'); pos != std::string_view::npos) {
+                view.fragment = body.substr(pos + 1);
+                body = body.substr(0, pos);
+            }
+            if (size_t pos = body.find('?'); pos != std::string_view::npos) {
+                view.query = body.substr(pos + 1);
+                body = body.substr(0, pos);
+            }
+            if (size_t pos = body.find('@'); pos != std::string_view::npos) {
+                view.userInfo = body.substr(0, pos);
+                view.hasUserInfo = true;
+                body = body.substr(pos + 1);
+            }
+            if (size_t pos = body.find_last_of(':'); pos != std::string_view::npos) {
+                view.host = body.substr(0, pos);
+                view.port = body.substr(pos + 1);
+            } else {
+                view.host = body;
+            }
+            return view;
+        }
+
         // NEW: Helper to parse URL query parameters
         inline std::map<std::string, std::string> parse_query_params(const std::string& query) {
             std::map<std::string, std::string> params;
@@ -113,16 +200,441 @@ namespace V2rayConfigWin
             return params;
         }
 
+        inline bool is_space(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+        }
+
+        inline std::string_view trim(std::string_view s) {
+            while (!s.empty() && is_space(s.front())) s.remove_prefix(1);
+            while (!s.empty() && is_space(s.back())) s.remove_suffix(1);
+            return s;
+        }
+
+        // ---------------------------------------------------------------------------------
+        // IP address classification
+        // ---------------------------------------------------------------------------------
+        using Ipv4Bytes = std::array<uint8_t, 4>;
+        using Ipv6Bytes = std::array<uint8_t, 16>;
+
+        // Dotted-quad IPv4, each part 0-255.
+        inline std::optional<Ipv4Bytes> parse_ipv4(std::string_view s) {
+            Ipv4Bytes bytes{};
+            for (int part = 0; part < 4; ++part) {
+                if (part > 0) {
+                    if (s.empty() || s.front() != '.') return std::nullopt;
+                    s.remove_prefix(1);
+                }
+                int value = 0, digits = 0;
+                while (!s.empty() && s.front() >= '0' && s.front() <= '9' && digits < 3) {
+                    value = value * 10 + (s.front() - '0');
+                    s.remove_prefix(1);
+                    ++digits;
+                }
+                if (digits == 0 || value > 255) return std::nullopt;
+                bytes[part] = static_cast<uint8_t>(value);
+            }
+            if (!s.empty()) return std::nullopt;
+            return bytes;
+        }
+
+        // RFC 4291 text form: up to eight hex groups, at most one "::", and an
+        // optional trailing dotted-quad. Square brackets are accepted.
+        inline std::optional<Ipv6Bytes> parse_ipv6(std::string_view s) {
+            if (s.size() >= 2 && s.front() == '[' && s.back() == ']') {
+                s = s.substr(1, s.size() - 2);
+            }
+            Ipv6Bytes bytes{};
+            int groups = 0;
+            int gap = -1; // group index where "::" expands
+            if (s.starts_with("::")) {
+                gap = 0;
+                s.remove_prefix(2);
+            }
+            while (!s.empty()) {
+                if (groups == 8) return std::nullopt;
+                // Embedded IPv4 can only close the address.
+                if (groups <= 6 && s.find('.') != std::string_view::npos && s.find(':') == std::string_view::npos) {
+                    auto v4 = parse_ipv4(s);
+                    if (!v4) return std::nullopt;
+                    std::copy(v4->begin(), v4->end(), bytes.begin() + groups * 2);
+                    groups += 2;
+                    s = {};
+                    break;
+                }
+                int value = 0, digits = 0;
+                while (!s.empty() && digits < 4) {
+                    int d = hex_digit_value(s.front());
+                    if (d < 0) break;
+                    value = (value << 4) | d;
+                    s.remove_prefix(1);
+                    ++digits;
+                }
+                if (digits == 0) return std::nullopt;
+                bytes[groups * 2] = static_cast<uint8_t>(value >> 8);
+                bytes[groups * 2 + 1] = static_cast<uint8_t>(value);
+                ++groups;
+                if (s.empty()) break;
+                if (s.front() != ':') return std::nullopt;
+                s.remove_prefix(1);
+                if (!s.empty() && s.front() == ':') {
+                    if (gap >= 0) return std::nullopt;
+                    gap = groups;
+                    s.remove_prefix(1);
+                } else if (s.empty()) {
+                    return std::nullopt; // trailing single ':'
+                }
+            }
+            if (gap < 0) {
+                if (groups != 8) return std::nullopt;
+            } else {
+                if (groups == 8) return std::nullopt;
+                // Slide the groups after the gap to the end.
+                const int tail = (groups - gap) * 2;
+                std::copy_backward(bytes.begin() + gap * 2, bytes.begin() + gap * 2 + tail, bytes.end());
+                std::fill(bytes.begin() + gap * 2, bytes.end() - tail, uint8_t{0});
+            }
+            return bytes;
+        }
+
+        // An address with an optional "/prefix". IPv4 prefixes are stored as
+        // IPv4-mapped IPv6 (::ffff:a.b.c.d) with the length offset by 96.
+        struct IpPrefix {
+            Ipv6Bytes bytes{};
+            int length = 128;
+            bool ipv4 = false;
+        };
+
+        inline std::optional<IpPrefix> parse_ip_prefix(std::string_view s) {
+            IpPrefix prefix;
+            std::string_view address = s;
+            std::optional<int> length;
+            if (size_t slash = s.find('/'); slash != std::string_view::npos) {
+                address = s.substr(0, slash);
+                std::string_view bits = s.substr(slash + 1);
+                int value = 0;
+                auto [ptr, ec] = std::from_chars(bits.data(), bits.data() + bits.size(), value);
+                if (bits.empty() || ec != std::errc() || ptr != bits.data() + bits.size()) return std::nullopt;
+                length = value;
+            }
+            if (auto v4 = parse_ipv4(address)) {
+                if (length && *length > 32) return std::nullopt;
+                prefix.ipv4 = true;
+                prefix.bytes[10] = prefix.bytes[11] = 0xFF;
+                std::copy(v4->begin(), v4->end(), prefix.bytes.begin() + 12);
+                prefix.length = 96 + length.value_or(32);
+                return prefix;
+            }
+            if (auto v6 = parse_ipv6(address)) {
+                if (length && *length > 128) return std::nullopt;
+                prefix.bytes = *v6;
+                prefix.length = length.value_or(128);
+                return prefix;
+            }
+            return std::nullopt;
+        }
+
+        inline bool is_ipv4_address(std::string_view s) { return parse_ipv4(s).has_value(); }
+        inline bool is_ipv6_address(std::string_view s) { return parse_ipv6(s).has_value(); }
+        inline bool is_cidr(std::string_view s) {
+            return s.find('/') != std::string_view::npos && parse_ip_prefix(s).has_value();
+        }
+
         // NEW: Utility functions translated from Kotlin
-        inline bool is_ip_address(const std::string& str) {
-            // This is a simplified check. For production, a more robust regex might be needed.
-            std::regex ip_pattern(R"(^(\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3})|(\[([0-9a-fA-F:]+)\])$)");
-            return std::regex_match(str, ip_pattern);
+        // IPv4 or IPv6 address, optionally with a CIDR prefix length.
+        inline bool is_ip_address(std::string_view str) {
+            return parse_ip_prefix(str).has_value();
         }
-        inline bool is_pure_ip_address(const std::string& str) {
-            std::regex ip_pattern(R"(^\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3}$)");
-            return std::regex_match(str, ip_pattern);
+        // A bare dotted-quad IPv4 address.
+        inline bool is_pure_ip_address(std::string_view str) {
+            return is_ipv4_address(str);
         }
+        // ---------------------------------------------------------------------------------
+        // On-demand JSON object scanning
+        // ---------------------------------------------------------------------------------
+        // One member of a JSON object as seen by scan_json_object. |raw| is the
+        // value's source text; for strings it excludes the quotes and is still
+        // escaped. Nested objects and arrays are validated and skipped.
+        struct JsonMemberView {
+            enum class Kind { String, Number, True, False, Null, Nested };
+            Kind kind = Kind::Null;
+            std::string_view raw;
+
+            // String values unescaped, numbers and booleans as written.
+            std::optional<std::string> text() const;
+        };
+
+        namespace detail {
+            inline void append_utf8(std::string& out, uint32_t cp) {
+                if (cp < 0x80) {
+                    out += static_cast<char>(cp);
+                } else if (cp < 0x800) {
+                    out += static_cast<char>(0xC0 | (cp >> 6));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    out += static_cast<char>(0xE0 | (cp >> 12));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (cp >> 18));
+                    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+            }
+
+            inline bool read_hex4(std::string_view s, size_t pos, uint32_t& value) {
+                if (pos + 4 > s.size()) return false;
+                value = 0;
+                for (size_t i = pos; i < pos + 4; ++i) {
+                    int d = hex_digit_value(s[i]);
+                    if (d < 0) return false;
+                    value = (value << 4) | static_cast<uint32_t>(d);
+                }
+                return true;
+            }
+
+            // Forward-only cursor used by scan_json_object. Every Skip/Read
+            // function leaves |pos| just past what it consumed, or returns false
+            // with |pos| at the offending byte.
+            struct JsonCursor {
+                std::string_view text;
+                size_t pos = 0;
+
+                void SkipSpace() {
+                    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) ++pos;
+                }
+
+                bool Consume(char c) {
+                    SkipSpace();
+                    if (pos < text.size() && text[pos] == c) { ++pos; return true; }
+                    return false;
+                }
+
+                // Leaves |body| spanning the characters between the quotes.
+                bool ReadString(std::string_view& body) {
+                    if (pos >= text.size() || text[pos] != '"') return false;
+                    const size_t start = ++pos;
+                    while (pos < text.size()) {
+                        const unsigned char c = static_cast<unsigned char>(text[pos]);
+                        if (c == '"') {
+                            body = text.substr(start, pos - start);
+                            ++pos;
+                            return true;
+                        }
+                        if (c < 0x20) return false;
+                        if (c == '\\') {
+                            if (++pos >= text.size()) return false;
+                            uint32_t unused = 0;
+                            switch (text[pos]) {
+                            case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't': break;
+                            case 'u': if (!read_hex4(text, pos + 1, unused)) return false; pos += 4; break;
+                            default: return false;
+                            }
+                        }
+                        ++pos;
+                    }
+                    return false;
+                }
+
+                bool ReadNumber() {
+                    const size_t start = pos;
+                    if (pos < text.size() && text[pos] == '-') ++pos;
+                    auto digits = [&]() {
+                        const size_t from = pos;
+                        while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') ++pos;
+                        return pos - from;
+                    };
+                    if (pos < text.size() && text[pos] == '0') {
+                        ++pos;
+                    } else if (digits() == 0) {
+                        return false;
+                    }
+                    if (pos < text.size() && text[pos] == '.') {
+                        ++pos;
+                        if (digits() == 0) return false;
+                    }
+                    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+                        ++pos;
+                        if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) ++pos;
+                        if (digits() == 0) return false;
+                    }
+                    return pos > start;
+                }
+
+                bool ReadLiteral(std::string_view literal) {
+                    if (text.substr(pos, literal.size()) != literal) return false;
+                    pos += literal.size();
+                    return true;
+                }
+
+                // Skips a complete value of any type.
+                bool SkipValue(int depth = 0) {
+                    if (depth > 64) return false;
+                    SkipSpace();
+                    if (pos >= text.size()) return false;
+                    std::string_view unused;
+                    switch (text[pos]) {
+                    case '"': return ReadString(unused);
+                    case 't': return ReadLiteral("true");
+                    case 'f': return ReadLiteral("false");
+                    case 'n': return ReadLiteral("null");
+                    case '{': case '[': {
+                        const char close = text[pos] == '{' ? '}' : ']';
+                        const bool isObject = close == '}';
+                        ++pos;
+                        if (Consume(close)) return true;
+                        do {
+                            if (isObject) {
+                                SkipSpace();
+                                if (!ReadString(unused) || !Consume(':')) return false;
+                            }
+                            if (!SkipValue(depth + 1)) return false;
+                        } while (Consume(','));
+                        return Consume(close);
+                    }
+                    default: return ReadNumber();
+                    }
+                }
+            };
+        }
+
+        inline std::optional<std::string> JsonMemberView::text() const {
+            switch (kind) {
+            case Kind::Number:
+            case Kind::True:
+            case Kind::False:
+                return std::string(raw);
+            case Kind::String:
+                break;
+            default:
+                return std::nullopt;
+            }
+            if (raw.find('\\') == std::string_view::npos) {
+                return std::string(raw);
+            }
+            // Escapes were validated by the scanner.
+            std::string out;
+            out.reserve(raw.size());
+            for (size_t i = 0; i < raw.size(); ++i) {
+                if (raw[i] != '\\') { out += raw[i]; continue; }
+                switch (raw[++i]) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp = 0;
+                    detail::read_hex4(raw, i + 1, cp);
+                    i += 4;
+                    uint32_t low = 0;
+                    if (cp >= 0xD800 && cp < 0xDC00 && i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u' &&
+                        detail::read_hex4(raw, i + 3, low) && low >= 0xDC00 && low < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else if (cp >= 0xD800 && cp < 0xE000) {
+                        cp = 0xFFFD; // unpaired surrogate
+                    }
+                    detail::append_utf8(out, cp);
+                    break;
+                }
+                default: out += raw[i]; break; // " \ /
+                }
+            }
+            return out;
+        }
+
+        // Walks the members of the JSON object in |text| in order, calling
+        // |onMember(key, value)| for each; keys are passed still escaped. No DOM
+        // is built and nothing is allocated. Returns the offset of the first
+        // syntax error, or std::nullopt if |text| is a well-formed object.
+        template <typename OnMember>
+        std::optional<size_t> scan_json_object(std::string_view text, OnMember&& onMember) {
+            detail::JsonCursor cursor{ text };
+            if (!cursor.Consume('{')) return cursor.pos;
+            if (!cursor.Consume('}')) {
+                do {
+                    std::string_view key;
+                    cursor.SkipSpace();
+                    if (!cursor.ReadString(key) || !cursor.Consume(':')) return cursor.pos;
+                    cursor.SkipSpace();
+                    if (cursor.pos >= text.size()) return cursor.pos;
+
+                    JsonMemberView value;
+                    const size_t start = cursor.pos;
+                    bool ok = false;
+                    switch (text[start]) {
+                    case '"': value.kind = JsonMemberView::Kind::String; ok = cursor.ReadString(value.raw); break;
+                    case 't': value.kind = JsonMemberView::Kind::True; ok = cursor.ReadLiteral("true"); break;
+                    case 'f': value.kind = JsonMemberView::Kind::False; ok = cursor.ReadLiteral("false"); break;
+                    case 'n': value.kind = JsonMemberView::Kind::Null; ok = cursor.ReadLiteral("null"); break;
+                    case '{': case '[': value.kind = JsonMemberView::Kind::Nested; ok = cursor.SkipValue(); break;
+                    default: value.kind = JsonMemberView::Kind::Number; ok = cursor.ReadNumber(); break;
+                    }
+                    if (!ok) return cursor.pos;
+                    if (value.kind != JsonMemberView::Kind::String) {
+                        value.raw = text.substr(start, cursor.pos - start);
+                    }
+                    onMember(key, value);
+                } while (cursor.Consume(','));
+                if (!cursor.Consume('}')) return cursor.pos;
+            }
+            cursor.SkipSpace();
+            if (cursor.pos != text.size()) return cursor.pos;
+            return std::nullopt;
+        }
+
+        // ---------------------------------------------------------------------------------
+        // Work splitting
+        // ---------------------------------------------------------------------------------
+
+        // Calls |fn|(begin, end) for consecutive ranges of |chunk| items covering
+        // [0, count), spread over |threads| threads including the caller (0 = one
+        // per hardware thread). Workers claim chunks from a shared counter, so
+        // neighbouring items stay on one core. If a thread can't be started the
+        // remaining work runs on those that did, at worst inline on the caller.
+        // If |fn| throws, no further chunks are started; once every thread has
+        // finished, the first exception is rethrown on the caller.
+        // Returns the number of threads that ran.
+        template <typename Fn>
+        inline size_t parallel_chunks(size_t count, size_t threads, size_t chunk, Fn&& fn) {
+            std::atomic<size_t> next{0};
+            std::exception_ptr error;
+            std::mutex errorMutex;
+            auto work = [&]() {
+                try {
+                    for (size_t begin = next.fetch_add(chunk); begin < count; begin = next.fetch_add(chunk)) {
+                        fn(begin, (std::min)(begin + chunk, count));
+                    }
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                    next.store(count);
+                }
+            };
+
+            if (threads == 0) {
+                threads = (std::max)(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+            }
+            threads = (std::min)(threads, (count + chunk - 1) / chunk);
+
+            std::vector<std::thread> pool;
+            try {
+                if (threads > 1) pool.reserve(threads - 1);
+                for (size_t t = 1; t < threads; ++t) {
+                    pool.emplace_back(work);
+                }
+            } catch (...) {
+                // Fewer workers; the chunks are still claimed by whoever is running.
+            }
+            work();
+            for (auto& worker : pool) {
+                worker.join();
+            }
+            if (error) std::rethrow_exception(error);
+            return pool.size() + 1;
+        }
+
         inline std::vector<std::string> get_remote_dns_servers() {
             // In a real app, this would come from user settings.
             return { "1.1.1.1", "8.8.8.8" };
@@ -137,7 +649,7 @@ namespace V2rayConfigWin
     // =================================================================================
 
     enum class EConfigType { VMESS = 1, CUSTOM = 2, SHADOWSOCKS = 3, SOCKS = 4, VLESS = 5, TROJAN = 6, WIREGUARD = 7 };
-    inline std::string get_protocol_scheme(EConfigType type) {
+    constexpr std::string_view get_protocol_scheme(EConfigType type) {
         switch (type) {
             case EConfigType::VMESS: return "vmess://";
             case EConfigType::SHADOWSOCKS: return "ss://";
@@ -153,22 +665,36 @@ namespace V2rayConfigWin
         std::string v = "2", ps = "", add = "", port = "", id = "", aid = "0", scy = "auto", net = "", type = "", host = "", path = "", tls = "", sni = "", alpn = "", fp = "";
     };
 
-    // JSON mapping for VmessQRCode
-    inline void from_json(const nlohmann::json& j, VmessQRCode& p) {
-        p.ps = j.value("ps", "");
-        p.add = j.value("add", "");
-        p.port = j.value("port", "");
-        p.id = j.value("id", "");
-        p.aid = j.value("aid", "0");
-        p.scy = j.value("scy", "auto");
-        p.net = j.value("net", "");
-        p.type = j.value("type", "");
-        p.host = j.value("host", "");
-        p.path = j.value("path", "");
-        p.tls = j.value("tls", "");
-        p.sni = j.value("sni", "");
-        p.alpn = j.value("alpn", "");
-        p.fp = j.value("fp", "");
+    // Fills |p| straight from the vmess payload text: only the members listed
+    // here are decoded and no json DOM is built. Numbers and booleans are kept
+    // as their text (many generators write "port": 443); members that are null,
+    // objects or arrays keep their defaults. Returns the offset of a syntax
+    // error, if any.
+    inline std::optional<size_t> extract_vmess_fields(std::string_view json, VmessQRCode& p) {
+        return Utils::scan_json_object(json, [&p](std::string_view key, const Utils::JsonMemberView& value) {
+            std::string* field = nullptr;
+            if (key.size() == 2) {
+                if (key == "ps") field = &p.ps;
+                else if (key == "id") field = &p.id;
+                else if (key == "fp") field = &p.fp;
+            } else if (key.size() == 3) {
+                if (key == "add") field = &p.add;
+                else if (key == "aid") field = &p.aid;
+                else if (key == "scy") field = &p.scy;
+                else if (key == "net") field = &p.net;
+                else if (key == "tls") field = &p.tls;
+                else if (key == "sni") field = &p.sni;
+            } else if (key.size() == 4) {
+                if (key == "port") field = &p.port;
+                else if (key == "type") field = &p.type;
+                else if (key == "host") field = &p.host;
+                else if (key == "path") field = &p.path;
+                else if (key == "alpn") field = &p.alpn;
+            }
+            if (field) {
+                if (auto text = value.text()) *field = std::move(*text);
+            }
+        });
     }
 
     namespace V2rayConfig {
@@ -262,6 +788,83 @@ namespace V2rayConfigWin
             std::optional<std::string> tag;
             NLOHMANN_DEFINE_TYPE_INTRUSIVE(OutboundBean, protocol, settings, streamSettings, tag);
         };
+
+        // JsonWriter counterparts of the NLOHMANN_DEFINE_TYPE_INTRUSIVE
+        // serializers above, members in sorted order as the DOM would have them.
+        inline void write_json(JsonWriter& w, const TlsSettings& v) {
+            w.beginObject();
+            write_member(w, "allowInsecure", v.allowInsecure);
+            write_member(w, "alpn", v.alpn);
+            write_member(w, "fingerprint", v.fingerprint);
+            write_member(w, "serverName", v.serverName);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const StreamSettings& v) {
+            w.beginObject();
+            write_member(w, "network", v.network);
+            write_member(w, "security", v.security);
+            write_member(w, "tlsSettings", v.tlsSettings);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const VnextUserBean& v) {
+            w.beginObject();
+            write_member(w, "alterId", v.alterId);
+            write_member(w, "encryption", v.encryption);
+            write_member(w, "flow", v.flow);
+            write_member(w, "id", v.id);
+            write_member(w, "security", v.security);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const VnextServerBean& v) {
+            w.beginObject();
+            write_member(w, "address", v.address);
+            write_member(w, "port", v.port);
+            write_member(w, "users", v.users);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const SocksUserBean& v) {
+            w.beginObject();
+            write_member(w, "pass", v.pass);
+            write_member(w, "user", v.user);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const ServerObjectBean& v) {
+            w.beginObject();
+            write_member(w, "address", v.address);
+            write_member(w, "flow", v.flow);
+            write_member(w, "method", v.method);
+            write_member(w, "password", v.password);
+            write_member(w, "port", v.port);
+            write_member(w, "users", v.users);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const OutboundSettings& v) {
+            w.beginObject();
+            write_member(w, "servers", v.servers);
+            write_member(w, "vnext", v.vnext);
+            w.endObject();
+        }
+
+        // |tagOverride|, when set, replaces the bean's own tag (generate() tags
+        // the server outbound as TAG_AGENT this way).
+        inline void write_outbound(JsonWriter& w, const OutboundBean& v, std::optional<std::string_view> tagOverride = std::nullopt) {
+            w.beginObject();
+            write_member(w, "protocol", v.protocol);
+            write_member(w, "settings", v.settings);
+            write_member(w, "streamSettings", v.streamSettings);
+            w.key("tag");
+            if (tagOverride) w.string(*tagOverride);
+            else V2rayConfigWin::write_json(w, v.tag);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const OutboundBean& v) { write_outbound(w, v); }
     }
 
     struct ServerConfig {
@@ -309,198 +912,978 @@ namespace V2rayConfigWin
         }
     };
 
+    // =================================================================================
+    // Server identity (canonical form and fingerprint)
+    // =================================================================================
+    // 128-bit fingerprint of a server's connection parameters. Two configs with
+    // the same fingerprint reach the same server the same way; remarks,
+    // subscription and timestamps are not part of it.
+    struct ServerFingerprint {
+        uint64_t low = 0;
+        uint64_t high = 0;
+
+        uint64_t value64() const { return low; }
+        bool operator==(const ServerFingerprint& other) const { return low == other.low && high == other.high; }
+        bool operator!=(const ServerFingerprint& other) const { return !(*this == other); }
+
+        std::string to_hex() const {
+            static constexpr char digits[] = "0123456789abcdef";
+            std::string out(32, '0');
+            for (int i = 0; i < 16; ++i) {
+                out[15 - i] = digits[(high >> (i * 4)) & 0xF];
+                out[31 - i] = digits[(low >> (i * 4)) & 0xF];
+            }
+            return out;
+        }
+    };
+
+    struct ServerFingerprintHash {
+        size_t operator()(const ServerFingerprint& fingerprint) const noexcept {
+            return static_cast<size_t>(fingerprint.low);
+        }
+    };
+
+    namespace Utils {
+        inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+        inline uint64_t fmix64(uint64_t k) {
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdULL;
+            k ^= k >> 33;
+            k *= 0xc4ceb9fe1a85ec53ULL;
+            k ^= k >> 33;
+            return k;
+        }
+
+        // MurmurHash3 x64_128 (Austin Appleby, public domain), little-endian loads.
+        inline ServerFingerprint murmur3_128(std::string_view data, uint32_t seed = 0) {
+            const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+            const size_t len = data.size();
+            const size_t nblocks = len / 16;
+            const uint64_t c1 = 0x87c37b91114253d5ULL;
+            const uint64_t c2 = 0x4cf5ad432745937fULL;
+            uint64_t h1 = seed, h2 = seed;
+
+            for (size_t i = 0; i < nblocks; ++i) {
+                uint64_t k1, k2;
+                std::memcpy(&k1, bytes + i * 16, 8);
+                std::memcpy(&k2, bytes + i * 16 + 8, 8);
+                k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+                h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+                k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+                h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+            }
+
+            const uint8_t* tail = bytes + nblocks * 16;
+            uint64_t k1 = 0, k2 = 0;
+            const size_t rest = len & 15;
+            for (size_t i = rest; i > 8; --i) k2 ^= uint64_t(tail[i - 1]) << ((i - 9) * 8);
+            if (rest > 8) { k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2; }
+            for (size_t i = (std::min)(rest, size_t{8}); i > 0; --i) k1 ^= uint64_t(tail[i - 1]) << ((i - 1) * 8);
+            if (rest > 0) { k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1; }
+
+            h1 ^= len; h2 ^= len;
+            h1 += h2; h2 += h1;
+            h1 = fmix64(h1); h2 = fmix64(h2);
+            h1 += h2; h2 += h1;
+            return { h1, h2 };
+        }
+
+        // Host names compare case-insensitively and without IPv6 brackets or a
+        // trailing root dot.
+        inline std::string canonical_host(std::string_view host) {
+            host = trim(host);
+            if (host.size() >= 2 && host.front() == '[' && host.back() == ']') host = host.substr(1, host.size() - 2);
+            if (!host.empty() && host.back() == '.') host.remove_suffix(1);
+            std::string out(host);
+            for (auto& c : out) {
+                if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+            }
+            return out;
+        }
+    }
+
+    // Stable text form of everything that identifies how |config| connects:
+    // one "name=<length>:value" line per field, with hosts lowercased and
+    // protocol defaults filled in. Useful for debugging fingerprints.
+    inline std::string canonical_form(const ServerConfig& config) {
+        std::string out;
+        out.reserve(256);
+        auto field = [&out](std::string_view name, std::string_view value) {
+            out += name;
+            out += '=';
+            out += std::to_string(value.size());
+            out += ':';
+            out += value;
+            out += '\n';
+        };
+        auto or_default = [](const std::string& value, std::string_view fallback) {
+            return value.empty() ? fallback : std::string_view(value);
+        };
+
+        field("type", std::to_string(static_cast<int>(config.configType)));
+        if (!config.outboundBean) return out;
+        const auto& outbound = *config.outboundBean;
+        field("protocol", outbound.protocol);
+
+        if (outbound.settings && outbound.settings->vnext) {
+            for (const auto& vnext : *outbound.settings->vnext) {
+                field("address", Utils::canonical_host(vnext.address));
+                field("port", std::to_string(vnext.port));
+                for (const auto& user : vnext.users) {
+                    field("id", Utils::trim(user.id));
+                    field("alterId", std::to_string(user.alterId));
+                    field("security", or_default(user.security, V2rayConfig::DEFAULT_SECURITY));
+                    field("encryption", or_default(user.encryption, "none"));
+                    field("flow", user.flow);
+                }
+            }
+        }
+        if (outbound.settings && outbound.settings->servers) {
+            for (const auto& server : *outbound.settings->servers) {
+                field("address", Utils::canonical_host(server.address));
+                field("port", std::to_string(server.port));
+                field("method", server.method);
+                field("password", server.password);
+                field("flow", server.flow);
+                if (server.users) {
+                    for (const auto& user : *server.users) {
+                        field("user", user.user);
+                        field("pass", user.pass);
+                    }
+                }
+            }
+        }
+        if (outbound.streamSettings) {
+            const auto& stream = *outbound.streamSettings;
+            field("network", stream.network && !stream.network->empty() ? std::string_view(*stream.network) : "tcp");
+            field("streamSecurity", stream.security.value_or(""));
+            if (stream.tlsSettings) {
+                const auto& tls = *stream.tlsSettings;
+                field("sni", Utils::canonical_host(tls.serverName.value_or("")));
+                field("fingerprint", tls.fingerprint.value_or(""));
+                field("allowInsecure", tls.allowInsecure.value_or(false) ? "1" : "0");
+                if (tls.alpn) {
+                    for (const auto& alpn : *tls.alpn) field("alpn", alpn);
+                }
+            }
+        }
+        return out;
+    }
+
+    inline ServerFingerprint fingerprint(const ServerConfig& config) {
+        return Utils::murmur3_128(canonical_form(config));
+    }
+
     // =================================================================================
     // AngConfigManager Logic (Link Parser)
     // =================================================================================
     namespace AngConfigManager {
+        enum class ImportStatus {
+            Ok = 0,
+            UnsupportedProtocol, // scheme not handled by importConfig
+            InvalidLink,         // recognised scheme, but the link is malformed
+            InvalidBase64,       // payload is not valid base64
+            InvalidJson,         // vmess payload is not a JSON object
+            MissingField,        // a required field (address, port, id, ...) is absent
+            InvalidPort,         // port is not a number in 1-65535
+            Duplicate,           // parsed, but identical to an earlier line (see BatchImportResult::merges)
+        };
+
+        // Outcome of parsing one share link. |offset| is the byte offset into the
+        // link where parsing failed; for InvalidJson it is the offset into the
+        // base64-decoded vmess payload.
+        struct ImportResult {
+            ImportStatus status = ImportStatus::Ok;
+            size_t offset = 0;
+            explicit operator bool() const { return status == ImportStatus::Ok; }
+        };
+
+        namespace detail {
+            inline ImportResult fail(ImportStatus status, size_t offset) {
+                return { status, offset };
+            }
+
+            inline bool parse_port(std::string_view s, int& port) {
+                int value = 0;
+                auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+                if (s.empty() || ec != std::errc() || ptr != s.data() + s.size() || value < 1 || value > 65535) {
+                    return false;
+                }
+                port = value;
+                return true;
+            }
+        }
+
         // Forward declarations for internal helpers
-        inline bool tryResolveVmess4Kitsunebi(const std::string& server, ServerConfig& config);
+        inline ImportResult tryResolveVmess4Kitsunebi(std::string_view server, ServerConfig& config);
+
+        inline ImportResult parseVmess(std::string_view str, ServerConfig& config) {
+            const size_t schemeLength = get_protocol_scheme(EConfigType::VMESS).length();
+            const bool allowInsecure = false;
+            config = ServerConfig::create(EConfigType::VMESS);
+            auto& streamSetting = config.outboundBean->streamSettings.value();
+
+            if (str.find('?') != std::string_view::npos) {
+                return tryResolveVmess4Kitsunebi(str, config);
+            }
+
+            std::string result;
+            if (auto decoded = Utils::decode_base64(str.substr(schemeLength), result); !decoded) {
+                return detail::fail(ImportStatus::InvalidBase64, schemeLength + decoded.offset);
+            }
+            if (result.empty()) return detail::fail(ImportStatus::MissingField, schemeLength);
 
-        inline std::optional<ServerConfig> importConfig(const std::string& str) {
+            VmessQRCode vmessQRCode;
+            if (auto errorOffset = extract_vmess_fields(result, vmessQRCode)) {
+                return detail::fail(ImportStatus::InvalidJson, *errorOffset);
+            }
+            if (vmessQRCode.add.empty() || vmessQRCode.port.empty() || vmessQRCode.id.empty() || vmessQRCode.net.empty()) {
+                return detail::fail(ImportStatus::MissingField, schemeLength);
+            }
+
+            auto& vnext = config.outboundBean->settings->vnext->at(0);
+            if (!detail::parse_port(vmessQRCode.port, vnext.port)) {
+                return detail::fail(ImportStatus::InvalidPort, schemeLength);
+            }
+            config.remarks = std::move(vmessQRCode.ps);
+            vnext.address = std::move(vmessQRCode.add);
+            vnext.users[0].id = std::move(vmessQRCode.id);
+            vnext.users[0].security = vmessQRCode.scy.empty() ? V2rayConfig::DEFAULT_SECURITY : vmessQRCode.scy;
+            vnext.users[0].alterId = Utils::parse_int(vmessQRCode.aid);
+
+            auto sni = streamSetting.populateTransportSettings(vmessQRCode.net, vmessQRCode.type, vmessQRCode.host, vmessQRCode.path, {}, {}, {}, {}, {});
+            auto fingerprint = vmessQRCode.fp.empty() ? (streamSetting.tlsSettings ? streamSetting.tlsSettings->fingerprint.value_or("") : "") : vmessQRCode.fp;
+            streamSetting.populateTlsSettings(vmessQRCode.tls, allowInsecure, vmessQRCode.sni.empty() ? sni : vmessQRCode.sni, fingerprint, vmessQRCode.alpn, {}, {}, {});
+            return {};
+        }
+
+        inline ImportResult parseVless(std::string_view str, ServerConfig& config) {
+            const size_t schemeLength = get_protocol_scheme(EConfigType::VLESS).length();
+            const bool allowInsecure = false;
+            auto link = Utils::split_share_link(str.substr(schemeLength));
+            if (!link.hasUserInfo || link.userInfo.empty()) return detail::fail(ImportStatus::MissingField, schemeLength);
+            if (link.host.empty()) return detail::fail(ImportStatus::MissingField, link.host.data() - str.data());
+
+            config = ServerConfig::create(EConfigType::VLESS);
+            auto& streamSetting = config.outboundBean->streamSettings.value();
+            auto& vnext = config.outboundBean->settings->vnext->at(0);
+            if (!detail::parse_port(link.port, vnext.port)) {
+                return detail::fail(ImportStatus::InvalidPort, link.port.data() ? link.port.data() - str.data() : str.size());
+            }
+            Utils::QueryParams query_params(link.query);
+
+            config.remarks = Utils::url_decode(link.fragment);
+            vnext.address = std::string(link.host);
+            vnext.users[0].id = std::string(link.userInfo);
+            vnext.users[0].encryption = query_params.get_or("encryption", "none");
+            vnext.users[0].flow = query_params.get_or("flow", "");
+
+            auto sni = streamSetting.populateTransportSettings(
+                query_params.get_or("type", "tcp"),
+                query_params.get("headerType"),
+                query_params.get("host"),
+                query_params.get("path"),
+                query_params.get("seed"),
+                query_params.get("quicSecurity"),
+                query_params.get("key"),
+                query_params.get("mode"),
+                query_params.get("serviceName")
+            );
+
+            std::string fingerprint = query_params.get_or("fp", "");
+            std::string final_sni = query_params.get_or("sni", sni);
+
+            streamSetting.populateTlsSettings(
+                query_params.get_or("security", ""),
+                allowInsecure,
+                final_sni,
+                fingerprint,
+                query_params.get_or("alpn", ""),
+                std::nullopt, std::nullopt, std::nullopt
+            );
+            return {};
+        }
+
+        inline ImportResult parseShadowsocks(std::string_view str, ServerConfig& config) {
+            const size_t schemeLength = get_protocol_scheme(EConfigType::SHADOWSOCKS).length();
+            config = ServerConfig::create(EConfigType::SHADOWSOCKS);
+            std::string_view body = str.substr(schemeLength);
+
+            size_t remark_pos = body.find('#');
+            if (remark_pos != std::string_view::npos) {
+                config.remarks = Utils::url_decode(body.substr(remark_pos + 1));
+                body = body.substr(0, remark_pos);
+            }
+
+            // Either base64(method:password)@host:port (SIP002) or the
+            // legacy base64(method:password@host:port). Offsets into the decoded
+            // legacy form are reported at the start of the payload.
+            std::string decoded;
+            std::string_view userInfo, hostPort;
+            size_t hostPortOffset = schemeLength;
+            size_t at_pos = body.find('@');
+            if (at_pos != std::string_view::npos) {
+                if (auto result = Utils::decode_base64(body.substr(0, at_pos), decoded); !result) {
+                    return detail::fail(ImportStatus::InvalidBase64, schemeLength + result.offset);
+                }
+                userInfo = decoded;
+                hostPort = body.substr(at_pos + 1);
+                hostPortOffset = schemeLength + at_pos + 1;
+            } else {
+                if (auto result = Utils::decode_base64(body, decoded); !result) {
+                    return detail::fail(ImportStatus::InvalidBase64, schemeLength + result.offset);
+                }
+                std::string_view whole = decoded;
+                size_t last_at = whole.rfind('@');
+                if (last_at == std::string_view::npos) return detail::fail(ImportStatus::InvalidLink, schemeLength);
+                userInfo = whole.substr(0, last_at);
+                hostPort = whole.substr(last_at + 1);
+            }
+
+            size_t method_end = userInfo.find(':');
+            if (method_end == 0 || method_end == std::string_view::npos) {
+                return detail::fail(ImportStatus::MissingField, schemeLength);
+            }
+            size_t port_pos = hostPort.rfind(':');
+            if (port_pos == 0 || port_pos == std::string_view::npos) {
+                return detail::fail(ImportStatus::MissingField, hostPortOffset);
+            }
+
+            auto& server = config.outboundBean->settings->servers->at(0);
+            if (!detail::parse_port(hostPort.substr(port_pos + 1), server.port)) {
+                return detail::fail(ImportStatus::InvalidPort, at_pos != std::string_view::npos ? hostPortOffset + port_pos + 1 : schemeLength);
+            }
+            server.method = std::string(userInfo.substr(0, method_end));
+            server.password = std::string(userInfo.substr(method_end + 1));
+            server.address = std::string(hostPort.substr(0, port_pos));
+            return {};
+        }
+
+        // Parses one share link into |config| without throwing on malformed
+        // input. Share links are parsed as std::string_view slices of the input;
+        // the only allocations are the decoded payloads and the ServerConfig fields.
+        inline ImportResult parseConfig(std::string_view str, ServerConfig& config) {
             if (str.empty()) {
+                return detail::fail(ImportStatus::MissingField, 0);
+            }
+            if (str.starts_with(get_protocol_scheme(EConfigType::VMESS))) {
+                return parseVmess(str, config);
+            }
+            // NEW: Added VLESS parsing logic
+            if (str.starts_with(get_protocol_scheme(EConfigType::VLESS))) {
+                return parseVless(str, config);
+            }
+            if (str.starts_with(get_protocol_scheme(EConfigType::SHADOWSOCKS))) {
+                return parseShadowsocks(str, config);
+            }
+            // ... Add other protocols (SOCKS, TROJAN) here if needed ...
+            return detail::fail(ImportStatus::UnsupportedProtocol, 0);
+        }
+
+        inline std::optional<ServerConfig> importConfig(std::string_view str) {
+            ServerConfig config;
+            if (!parseConfig(str, config)) {
                 return std::nullopt;
             }
+            return config;
+        }
 
-            try {
-                ServerConfig config;
-                bool parsed = false;
-                const bool allowInsecure = false;
+        inline ImportResult tryResolveVmess4Kitsunebi(std::string_view server, ServerConfig& config) {
+            const size_t schemeLength = get_protocol_scheme(EConfigType::VMESS).length();
+            std::string_view body = server.substr(schemeLength);
+            size_t query_pos = body.find('?');
+            if (query_pos != std::string_view::npos) {
+                body = body.substr(0, query_pos);
+            }
+            std::string decoded;
+            if (auto result = Utils::decode_base64(body, decoded); !result) {
+                return detail::fail(ImportStatus::InvalidBase64, schemeLength + result.offset);
+            }
+            std::string_view result = decoded;
 
-                if (str.rfind(get_protocol_scheme(EConfigType::VMESS), 0) == 0) {
-                    config = ServerConfig::create(EConfigType::VMESS);
-                    if (!config.outboundBean || !config.outboundBean->streamSettings) return std::nullopt;
-                    auto& streamSetting = config.outboundBean->streamSettings.value();
+            // security:id@address:port
+            size_t at_pos = result.find('@');
+            if (at_pos == std::string_view::npos || result.find('@', at_pos + 1) != std::string_view::npos) {
+                return detail::fail(ImportStatus::InvalidLink, schemeLength);
+            }
+            std::string_view userPart = result.substr(0, at_pos);
+            std::string_view serverPart = result.substr(at_pos + 1);
+
+            size_t user_colon = userPart.find(':');
+            size_t server_colon = serverPart.find(':');
+            if (user_colon == std::string_view::npos || userPart.find(':', user_colon + 1) != std::string_view::npos ||
+                server_colon == std::string_view::npos || serverPart.find(':', server_colon + 1) != std::string_view::npos) {
+                return detail::fail(ImportStatus::InvalidLink, schemeLength);
+            }
 
-                    if (str.find('?') != std::string::npos) {
-                        if (!tryResolveVmess4Kitsunebi(str, config)) {
-                            return std::nullopt;
-                        }
+            auto& vnext = config.outboundBean->settings->vnext->at(0);
+            if (!detail::parse_port(serverPart.substr(server_colon + 1), vnext.port)) {
+                return detail::fail(ImportStatus::InvalidPort, schemeLength);
+            }
+            config.remarks = "Kitsunebi/Alien";
+            vnext.address = std::string(serverPart.substr(0, server_colon));
+            vnext.users[0].id = std::string(userPart.substr(user_colon + 1));
+            vnext.users[0].security = std::string(userPart.substr(0, user_colon));
+            vnext.users[0].alterId = 0;
+            return {};
+        }
+
+        // A duplicate line folded into the first line with the same fingerprint.
+        // Both are indices into BatchImportResult::status.
+        struct ImportMerge {
+            size_t line;
+            size_t keptLine;
+        };
+
+        struct BatchImportResult {
+            std::vector<ServerConfig> configs; // one per Ok line, in input order
+            std::vector<ImportStatus> status;  // one per non-blank input line, in input order
+            std::vector<ImportMerge> merges;   // duplicates dropped from |configs|
+            size_t cacheHits = 0;              // lines served by the LinkCache instead of the parser
+        };
+
+        // Memo of link text -> parsed ServerConfig consulted by importBatch.
+        // lookup() is called concurrently from the worker threads and must be
+        // safe for that; store() is only called from the importing thread after
+        // the workers have finished, so the two never overlap.
+        class LinkCache {
+        public:
+            virtual ~LinkCache() = default;
+            virtual bool lookup(std::string_view link, ServerConfig& out) const = 0;
+            virtual void store(std::string_view link, const ServerConfig& config) = 0;
+        };
+
+        // Splits a subscription into its non-blank lines. A body without any
+        // "://" is treated as a base64 blob and decoded first; |decoded| owns the
+        // text the returned views point into in that case.
+        inline std::vector<std::string_view> split_subscription(std::string_view subscription, std::string& decoded) {
+            if (subscription.find("://") == std::string_view::npos) {
+                decoded.clear();
+                if (Utils::decode_base64(subscription, decoded, Utils::Base64Alphabet::Any)) {
+                    subscription = decoded;
+                }
+            }
+
+            std::vector<std::string_view> lines;
+            while (!subscription.empty()) {
+                size_t eol = subscription.find('\n');
+                std::string_view line = subscription.substr(0, eol);
+                subscription = eol == std::string_view::npos ? std::string_view{} : subscription.substr(eol + 1);
+                while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.remove_suffix(1);
+                while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) line.remove_prefix(1);
+                if (!line.empty()) lines.push_back(line);
+            }
+            return lines;
+        }
+
+        // Parses every link of a subscription (newline separated, or one base64
+        // blob) across a pool of worker threads. Results keep the input order
+        // regardless of which worker parsed them. |threads| == 0 uses one worker
+        // per hardware thread; small inputs are parsed on the calling thread.
+        //
+        // With |deduplicate|, a link whose ServerFingerprint matches an earlier
+        // one is marked Duplicate and reported in |merges|; the first stays.
+        //
+        // With a |cache|, links it already knows skip the parser entirely and
+        // newly parsed ones are stored into it once the workers are done.
+        inline BatchImportResult importBatch(std::string_view subscription, size_t threads = 0, bool deduplicate = true,
+                                             LinkCache* cache = nullptr) {
+            std::string decoded;
+            const auto lines = split_subscription(subscription, decoded);
+            const size_t count = lines.size();
+
+            std::vector<std::optional<ServerConfig>> parsed(count);
+            std::vector<ImportStatus> status(count, ImportStatus::Ok);
+            std::vector<ServerFingerprint> fingerprints(deduplicate ? count : 0);
+            std::vector<uint8_t> cached(cache ? count : 0);
+
+            Utils::parallel_chunks(count, threads, 32, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    ServerConfig config;
+                    if (cache && cache->lookup(lines[i], config)) {
+                        cached[i] = 1;
                     } else {
-                        std::string result = str.substr(get_protocol_scheme(EConfigType::VMESS).length());
-                        result = Utils::decode_base64(result);
-                        if (result.empty()) return std::nullopt;
+                        status[i] = parseConfig(lines[i], config).status;
+                        if (status[i] != ImportStatus::Ok) continue;
+                    }
+                    if (deduplicate) fingerprints[i] = fingerprint(config);
+                    parsed[i] = std::move(config);
+                }
+            });
+
+            BatchImportResult result;
+            result.configs.reserve(count);
+            std::unordered_map<ServerFingerprint, size_t, ServerFingerprintHash> firstLine;
+            if (deduplicate) firstLine.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                if (!parsed[i]) continue;
+                if (cache) {
+                    if (cached[i]) ++result.cacheHits;
+                    else cache->store(lines[i], *parsed[i]);
+                }
+                if (deduplicate) {
+                    auto [it, inserted] = firstLine.try_emplace(fingerprints[i], i);
+                    if (!inserted) {
+                        status[i] = ImportStatus::Duplicate;
+                        result.merges.push_back({ i, it->second });
+                        continue;
+                    }
+                }
+                result.configs.push_back(std::move(*parsed[i]));
+            }
+            result.status = std::move(status);
+            return result;
+        }
+
+        // Push-style counterpart of importBatch for subscriptions that arrive in
+        // chunks (e.g. straight from the download layer). Base64 bodies are
+        // decoded incrementally and every completed line is parsed and handed to
+        // |onConfig| immediately, so memory stays bounded by the chunk size and
+        // the longest line rather than by the subscription.
+        //
+        // Whether the body is base64 is decided from its first bytes: any
+        // character outside the base64 alphabet (such as the ':' of "://") means
+        // plain links; kProbeLength alphabet-only characters mean base64. Unlike
+        // split_subscription, a base64 body that fails to decode is an error
+        // rather than a fallback to plain text, since lines have already been
+        // emitted by then.
+        class SubscriptionStream {
+        public:
+            using ConfigSink = std::function<void(ServerConfig&& config)>;
+            // |line| counts non-blank lines, as BatchImportResult::status does.
+            using ErrorSink = std::function<void(size_t line, ImportResult result)>;
+
+            static constexpr size_t kProbeLength = 64;
+            static constexpr size_t kMaxLineLength = 64 * 1024;
+
+            explicit SubscriptionStream(ConfigSink onConfig, ErrorSink onError = {})
+                : m_onConfig(std::move(onConfig)), m_onError(std::move(onError)) {}
+
+            // Returns false once the stream has failed (see error()).
+            bool push(std::string_view chunk) {
+                if (m_failed) return false;
+                if (m_mode == Mode::Detecting) {
+                    m_probe.append(chunk);
+                    if (!detect(false)) return true;
+                    std::string probe = std::move(m_probe);
+                    m_probe = {};
+                    return feed(probe);
+                }
+                return feed(chunk);
+            }
+
+            // Flushes the last line. Returns false if the stream failed.
+            bool finish() {
+                if (m_failed) return false;
+                if (m_mode == Mode::Detecting) {
+                    detect(true);
+                    std::string probe = std::move(m_probe);
+                    m_probe = {};
+                    if (!feed(probe)) return false;
+                }
+                if (m_mode == Mode::Base64) {
+                    m_decoded.clear();
+                    if (auto result = m_base64.finish(m_decoded); !result) return fail(result);
+                    split_lines(m_decoded);
+                }
+                end_line();
+                return true;
+            }
+
+            bool isBase64() const { return m_mode == Mode::Base64; }
+            size_t lines() const { return m_lines; }
+            size_t configs() const { return m_configs; }
+            // Offset into the raw (still encoded) stream when decoding failed.
+            const Utils::Base64DecodeResult& error() const { return m_error; }
+
+        private:
+            enum class Mode { Detecting, Plain, Base64 };
+
+            bool detect(bool atEnd) {
+                size_t significant = 0;
+                for (char c : m_probe) {
+                    if (Utils::is_space(c)) continue;
+                    const bool alphabet = std::isalnum(static_cast<unsigned char>(c)) || c == '+' || c == '/' ||
+                                          c == '-' || c == '_' || c == '=';
+                    if (!alphabet) {
+                        m_mode = Mode::Plain;
+                        return true;
+                    }
+                    ++significant;
+                }
+                if (significant >= kProbeLength || (atEnd && significant > 0)) {
+                    m_mode = Mode::Base64;
+                } else if (atEnd) {
+                    m_mode = Mode::Plain;
+                }
+                return m_mode != Mode::Detecting;
+            }
+
+            bool feed(std::string_view text) {
+                if (m_mode == Mode::Plain) {
+                    split_lines(text);
+                    return true;
+                }
+                m_decoded.clear();
+                if (auto result = m_base64.push(text, m_decoded); !result) return fail(result);
+                split_lines(m_decoded);
+                return true;
+            }
+
+            bool fail(const Utils::Base64DecodeResult& result) {
+                m_failed = true;
+                m_error = result;
+                return false;
+            }
+
+            void split_lines(std::string_view text) {
+                while (!text.empty()) {
+                    const size_t eol = text.find('\n');
+                    const std::string_view piece = text.substr(0, eol);
+                    if (m_line.size() + piece.size() > kMaxLineLength) {
+                        m_overlong = true;
+                        m_line.clear();
+                    } else if (!m_overlong) {
+                        if (eol != std::string_view::npos && m_line.empty()) {
+                            // Whole line inside this chunk: parse it in place.
+                            process(piece);
+                        } else {
+                            m_line.append(piece);
+                        }
+                    }
+                    if (eol == std::string_view::npos) return;
+                    end_line();
+                    text.remove_prefix(eol + 1);
+                }
+            }
+
+            void end_line() {
+                if (m_overlong) {
+                    report({ ImportStatus::InvalidLink, kMaxLineLength });
+                    m_overlong = false;
+                } else if (!m_line.empty()) {
+                    process(m_line);
+                }
+                m_line.clear();
+            }
+
+            void process(std::string_view line) {
+                line = Utils::trim(line);
+                if (line.empty()) return;
+                ServerConfig config;
+                if (auto result = parseConfig(line, config); !result) {
+                    report(result);
+                    return;
+                }
+                ++m_lines;
+                ++m_configs;
+                m_onConfig(std::move(config));
+            }
+
+            void report(ImportResult result) {
+                if (m_onError) m_onError(m_lines, result);
+                ++m_lines;
+            }
+
+            ConfigSink m_onConfig;
+            ErrorSink m_onError;
+            Mode m_mode = Mode::Detecting;
+            std::string m_probe;   // input held back until the mode is known
+            std::string m_decoded; // scratch for the current chunk's decoded bytes
+            std::string m_line;    // partial line spanning chunks
+            Utils::Base64StreamDecoder m_base64;
+            Utils::Base64DecodeResult m_error;
+            size_t m_lines = 0;
+            size_t m_configs = 0;
+            bool m_overlong = false;
+            bool m_failed = false;
+        };
+    } // namespace AngConfigManager
+
+    // =================================================================================
+    // User routing rule compilation
+    // =================================================================================
+    namespace RoutingRules {
+        // A comma-separated user rule list reduced to the entries the core needs:
+        // domain and IP entries deduplicated, domains covered by a "domain:"
+        // entry dropped, and CIDR ranges merged. Both arrays go into the same
+        // rule, so their order carries no meaning.
+        struct CompiledRules {
+            std::vector<std::string> domains;
+            std::vector<std::string> ips;
+        };
+
+        namespace detail {
+            // An address range in the IpPrefix space (IPv4 mapped into IPv6) as two
+            // 64-bit halves, host bits cleared.
+            struct Range {
+                uint64_t high = 0;
+                uint64_t low = 0;
+                int length = 128;
+                bool ipv4 = false;
+
+                bool operator<(const Range& other) const {
+                    if (ipv4 != other.ipv4) return ipv4;
+                    if (high != other.high) return high < other.high;
+                    if (low != other.low) return low < other.low;
+                    return length < other.length;
+                }
+            };
+
+            // The address with only its first |length| bits kept.
+            inline Range masked(Range r, int length) {
+                r.length = length;
+                if (length <= 0) {
+                    r.high = r.low = 0;
+                } else if (length < 64) {
+                    r.high &= ~uint64_t{0} << (64 - length);
+                    r.low = 0;
+                } else if (length == 64) {
+                    r.low = 0;
+                } else if (length < 128) {
+                    r.low &= ~uint64_t{0} << (128 - length);
+                }
+                return r;
+            }
+
+            inline Range to_range(const Utils::IpPrefix& prefix) {
+                Range r;
+                for (int i = 0; i < 8; ++i) {
+                    r.high = (r.high << 8) | prefix.bytes[i];
+                    r.low = (r.low << 8) | prefix.bytes[i + 8];
+                }
+                r.ipv4 = prefix.ipv4;
+                return masked(r, prefix.length);
+            }
+
+            inline bool contains(const Range& outer, const Range& inner) {
+                if (outer.ipv4 != inner.ipv4 || outer.length > inner.length) return false;
+                const Range cut = masked(inner, outer.length);
+                return cut.high == outer.high && cut.low == outer.low;
+            }
 
-                        auto vmessQRCode = nlohmann::json::parse(result).get<VmessQRCode>();
-                        if (vmessQRCode.add.empty() || vmessQRCode.port.empty() || vmessQRCode.id.empty() || vmessQRCode.net.empty()) {
-                            return std::nullopt;
-                        }
+            // The enclosing prefix if |a| and |b| are the two halves of it.
+            inline std::optional<Range> merge_siblings(const Range& a, const Range& b) {
+                // IPv4 prefixes stop at /0, which is /96 in the mapped space.
+                if (a.ipv4 != b.ipv4 || a.length != b.length || a.length <= (a.ipv4 ? 96 : 0)) return std::nullopt;
+                const Range parent = masked(a, a.length - 1);
+                const Range other = masked(b, b.length - 1);
+                if (parent.high != other.high || parent.low != other.low || (a.high == b.high && a.low == b.low)) return std::nullopt;
+                return parent;
+            }
 
-                        config.remarks = vmessQRCode.ps;
-                        auto& vnext = config.outboundBean->settings->vnext->at(0);
-                        vnext.address = vmessQRCode.add;
-                        vnext.port = Utils::parse_int(vmessQRCode.port);
-                        vnext.users[0].id = vmessQRCode.id;
-                        vnext.users[0].security = vmessQRCode.scy.empty() ? V2rayConfig::DEFAULT_SECURITY : vmessQRCode.scy;
-                        vnext.users[0].alterId = Utils::parse_int(vmessQRCode.aid);
-
-                        auto sni = streamSetting.populateTransportSettings(vmessQRCode.net, vmessQRCode.type, vmessQRCode.host, vmessQRCode.path, {}, {}, {}, {}, {});
-                        auto fingerprint = vmessQRCode.fp.empty() ? (streamSetting.tlsSettings ? streamSetting.tlsSettings->fingerprint.value_or("") : "") : vmessQRCode.fp;
-                        streamSetting.populateTlsSettings(vmessQRCode.tls, allowInsecure, vmessQRCode.sni.empty() ? sni : vmessQRCode.sni, fingerprint, vmessQRCode.alpn, {}, {}, {});
-                    }
-                    parsed = true;
-                } 
-                // NEW: Added VLESS parsing logic
-                else if (str.rfind(get_protocol_scheme(EConfigType::VLESS), 0) == 0) {
-                    std::string full_uri = str.substr(get_protocol_scheme(EConfigType::VLESS).length());
-                    
-                    std::string remarks;
-                    size_t fragment_pos = full_uri.find('#');
-                    if (fragment_pos != std::string::npos) {
-                        remarks = Utils::url_decode(full_uri.substr(fragment_pos + 1));
-                        full_uri = full_uri.substr(0, fragment_pos);
-                    }
-
-                    std::string query_str;
-                    size_t query_pos = full_uri.find('?');
-                    if (query_pos != std::string::npos) {
-                        query_str = full_uri.substr(query_pos + 1);
-                        full_uri = full_uri.substr(0, query_pos);
-                    }
-                    auto query_params = Utils::parse_query_params(query_str);
-
-                    size_t at_pos = full_uri.find('@');
-                    if (at_pos == std::string::npos) return std::nullopt; // Invalid format
-
-                    std::string user_id = full_uri.substr(0, at_pos);
-                    std::string host_port = full_uri.substr(at_pos + 1);
-
-                    std::string host;
-                    int port = 0;
-                    size_t port_pos = host_port.find_last_of(':');
-                    if (port_pos != std::string::npos) {
-                        host = host_port.substr(0, port_pos);
-                        port = Utils::parse_int(host_port.substr(port_pos + 1));
-                    } else {
-                        host = host_port;
+            // Sorts |ranges| and reduces them to the fewest prefixes covering the same
+            // addresses: contained ranges are dropped and sibling halves joined.
+            inline std::vector<Range> aggregate(std::vector<Range> ranges) {
+                std::sort(ranges.begin(), ranges.end());
+                std::vector<Range> kept;
+                kept.reserve(ranges.size());
+                for (const Range& r : ranges) {
+                    if (!kept.empty() && contains(kept.back(), r)) continue;
+                    kept.push_back(r);
+                    while (kept.size() >= 2) {
+                        auto parent = merge_siblings(kept[kept.size() - 2], kept.back());
+                        if (!parent) break;
+                        kept.pop_back();
+                        kept.back() = *parent;
                     }
+                }
+                return kept;
+            }
 
-                    config = ServerConfig::create(EConfigType::VLESS);
-                    auto& streamSetting = config.outboundBean->streamSettings.value();
+            // Dotted-quad for IPv4; RFC 5952 compressed form for IPv6. The prefix
+            // length is left off for single addresses.
+            inline std::string format_range(const Range& r) {
+                std::string out;
+                char buffer[8];
+                if (r.ipv4) {
+                    for (int i = 0; i < 4; ++i) {
+                        if (i > 0) out += '.';
+                        auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, (r.low >> (24 - 8 * i)) & 0xFF);
+                        out.append(buffer, end);
+                    }
+                    if (r.length < 128) {
+                        out += '/';
+                        out += std::to_string(r.length - 96);
+                    }
+                    return out;
+                }
 
-                    config.remarks = remarks;
-                    auto& vnext = config.outboundBean->settings->vnext->at(0);
-                    vnext.address = host;
-                    vnext.port = port;
-                    vnext.users[0].id = user_id;
-                    vnext.users[0].encryption = query_params.count("encryption") ? query_params.at("encryption") : "none";
-                    vnext.users[0].flow = query_params.count("flow") ? query_params.at("flow") : "";
+                uint16_t groups[8];
+                for (int i = 0; i < 4; ++i) {
+                    groups[i] = static_cast<uint16_t>(r.high >> (48 - 16 * i));
+                    groups[i + 4] = static_cast<uint16_t>(r.low >> (48 - 16 * i));
+                }
+                int gapStart = -1, gapLength = 0;
+                for (int i = 0; i < 8;) {
+                    if (groups[i] != 0) { ++i; continue; }
+                    int j = i;
+                    while (j < 8 && groups[j] == 0) ++j;
+                    if (j - i > gapLength && j - i >= 2) {
+                        gapStart = i;
+                        gapLength = j - i;
+                    }
+                    i = j;
+                }
+                for (int i = 0; i < 8; ++i) {
+                    if (i == gapStart) {
+                        out += "::";
+                        i += gapLength - 1;
+                        continue;
+                    }
+                    if (i > 0 && i != gapStart + gapLength) out += ':';
+                    auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, groups[i], 16);
+                    out.append(buffer, end);
+                }
+                if (r.length < 128) {
+                    out += '/';
+                    out += std::to_string(r.length);
+                }
+                return out;
+            }
 
-                    auto get_query_param = [&](const std::string& key) -> std::optional<std::string> {
-                        if (query_params.count(key)) return query_params.at(key);
-                        return std::nullopt;
-                    };
+            // True if "domain:" |host| or any parent of it is in |suffixes|,
+            // excluding |host| itself unless |includeSelf|.
+            inline bool covered_by(std::string_view host, const std::unordered_set<std::string_view>& suffixes, bool includeSelf) {
+                if (includeSelf && suffixes.count(host)) return true;
+                for (size_t dot = host.find('.'); dot != std::string_view::npos; dot = host.find('.', dot + 1)) {
+                    if (suffixes.count(host.substr(dot + 1))) return true;
+                }
+                return false;
+            }
+        }
 
-                    auto sni = streamSetting.populateTransportSettings(
-                        query_params.count("type") ? query_params.at("type") : "tcp",
-                        get_query_param("headerType"),
-                        get_query_param("host"),
-                        get_query_param("path"),
-                        get_query_param("seed"),
-                        get_query_param("quicSecurity"),
-                        get_query_param("key"),
-                        get_query_param("mode"),
-                        get_query_param("serviceName")
-                    );
-
-                    std::string fingerprint = query_params.count("fp") ? query_params.at("fp") : "";
-                    std::string final_sni = query_params.count("sni") ? query_params.at("sni") : sni;
-                    
-                    streamSetting.populateTlsSettings(
-                        query_params.count("security") ? query_params.at("security") : "",
-                        allowInsecure,
-                        final_sni,
-                        fingerprint,
-                        query_params.count("alpn") ? query_params.at("alpn") : "",
-                        std::nullopt, std::nullopt, std::nullopt
-                    );
-                    parsed = true;
-                }
-                else if (str.rfind(get_protocol_scheme(EConfigType::SHADOWSOCKS), 0) == 0) {
-                    config = ServerConfig::create(EConfigType::SHADOWSOCKS);
-                    std::string result = str.substr(get_protocol_scheme(EConfigType::SHADOWSOCKS).length());
-
-                    size_t remark_pos = result.find('#');
-                    if (remark_pos != std::string::npos) {
-                        config.remarks = Utils::url_decode(result.substr(remark_pos + 1));
-                        result = result.substr(0, remark_pos);
-                    }
-
-                    size_t at_pos = result.find('@');
-                    if (at_pos != std::string::npos) {
-                        result = Utils::decode_base64(result.substr(0, at_pos)) + result.substr(at_pos);
-                    } else {
-                        result = Utils::decode_base64(result);
+        // Compiles a comma-separated rule list. Entries are trimmed; IP addresses,
+        // CIDRs and "geoip:" entries go to |ips|, everything else to |domains|.
+        // "domain:", "full:" and "geosite:" values are lowercased, since the core
+        // matches them case-insensitively; keyword and regexp entries are kept
+        // verbatim.
+        inline CompiledRules compile(std::string_view text) {
+            CompiledRules compiled;
+            std::vector<std::string> domains;
+            std::unordered_set<std::string> seenDomains, seenIps;
+            std::vector<detail::Range> ranges;
+
+            while (!text.empty()) {
+                const size_t comma = text.find(',');
+                std::string_view entry = Utils::trim(text.substr(0, comma));
+                text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+                if (entry.empty()) continue;
+
+                if (auto prefix = Utils::parse_ip_prefix(entry)) {
+                    ranges.push_back(detail::to_range(*prefix));
+                } else if (entry.starts_with("geoip:")) {
+                    if (seenIps.emplace(entry).second) compiled.ips.emplace_back(entry);
+                } else {
+                    std::string domain;
+                    for (std::string_view type : { "domain:", "full:", "geosite:" }) {
+                        if (entry.starts_with(type)) {
+                            domain = std::string(type) + Utils::canonical_host(entry.substr(type.size()));
+                            break;
+                        }
                     }
+                    if (domain.empty()) domain = entry;
+                    if (seenDomains.insert(domain).second) domains.push_back(std::move(domain));
+                }
+            }
 
-                    std::regex legacy_pattern(R"((.+?):(.*)@(.+?):(\d+))");
-                    std::smatch match;
-                    if (std::regex_match(result, match, legacy_pattern)) {
-                        auto& server = config.outboundBean->settings->servers->at(0);
-                        server.method = match[1].str();
-                        server.password = match[2].str();
-                        server.address = match[3].str();
-                        server.port = Utils::parse_int(match[4].str());
-                        parsed = true;
-                    }
-                } 
-                // ... Add other protocols (SOCKS, TROJAN) here if needed ...
+            std::unordered_set<std::string_view> suffixes;
+            for (const auto& domain : domains) {
+                if (domain.starts_with("domain:")) suffixes.insert(std::string_view(domain).substr(7));
+            }
+            compiled.domains.reserve(domains.size());
+            for (auto& domain : domains) {
+                const std::string_view value(domain);
+                if (value.starts_with("domain:") && detail::covered_by(value.substr(7), suffixes, false)) continue;
+                if (value.starts_with("full:") && detail::covered_by(value.substr(5), suffixes, true)) continue;
+                compiled.domains.push_back(std::move(domain));
+            }
 
-                if (parsed) {
-                    return config;
-                }
-                return std::nullopt;
+            for (const auto& range : detail::aggregate(std::move(ranges))) {
+                compiled.ips.push_back(detail::format_range(range));
+            }
+            return compiled;
+        }
 
-            } catch (const std::exception& e) {
-                std::cerr << "Error parsing config: " << e.what() << std::endl;
-                return std::nullopt;
+        namespace detail {
+            struct CompileCache {
+                std::mutex mutex;
+                std::unordered_map<ServerFingerprint, std::shared_ptr<const CompiledRules>, ServerFingerprintHash> entries;
+            };
+
+            inline CompileCache& compile_cache() {
+                static CompileCache cache;
+                return cache;
             }
+
+            // Agent, direct and blocked lists for a handful of profiles.
+            inline constexpr size_t kCompileCacheCapacity = 32;
         }
 
-        inline bool tryResolveVmess4Kitsunebi(const std::string& server, ServerConfig& config) {
-            std::string result = server.substr(get_protocol_scheme(EConfigType::VMESS).length());
-            size_t query_pos = result.find('?');
-            if (query_pos != std::string::npos) {
-                result = result.substr(0, query_pos);
+        // compile() behind a process-wide cache keyed by the 128-bit hash of
+        // |text|, so a rule list is only parsed and merged again when it changes.
+        // The result is shared and immutable.
+        inline std::shared_ptr<const CompiledRules> compile_cached(std::string_view text) {
+            const ServerFingerprint key = Utils::murmur3_128(text);
+            auto& cache = detail::compile_cache();
+            {
+                std::lock_guard<std::mutex> lock(cache.mutex);
+                if (auto it = cache.entries.find(key); it != cache.entries.end()) return it->second;
             }
-            result = Utils::decode_base64(result);
 
-            auto arr1 = Utils::split(result, '@');
-            if (arr1.size() != 2) return false;
+            // Compile outside the lock; a concurrent miss on the same text just
+            // does the work twice.
+            auto compiled = std::make_shared<const CompiledRules>(compile(text));
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            if (cache.entries.size() >= detail::kCompileCacheCapacity) cache.entries.clear();
+            return cache.entries.emplace(key, std::move(compiled)).first->second;
+        }
 
-            auto arr21 = Utils::split(arr1[0], ':');
-            auto arr22 = Utils::split(arr1[1], ':');
-            if (arr21.size() != 2 || arr22.size() != 2) return false;
+        inline void clear_compile_cache() {
+            auto& cache = detail::compile_cache();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+            cache.entries.clear();
+        }
 
-            config.remarks = "Kitsunebi/Alien";
-            auto& vnext = config.outboundBean->settings->vnext->at(0);
-            vnext.address = arr22[0];
-            vnext.port = Utils::parse_int(arr22[1]);
-            vnext.users[0].id = arr21[1];
-            vnext.users[0].security = arr21[0];
-            vnext.users[0].alterId = 0;
+        // The categories in the core's geoip.dat and geosite.dat; implemented by
+        // GeoIndex (V2rayGeoIndex.h). Codes compare case-insensitively.
+        class GeoCatalog {
+        public:
+            virtual ~GeoCatalog() = default;
+            virtual bool hasGeoip(std::string_view code) const = 0;
+            virtual bool hasGeosite(std::string_view code) const = 0;
+            // Changes whenever the set of categories does.
+            virtual uint64_t fingerprint() const = 0;
+        };
+
+        // False only for a "geoip:" or "geosite:" entry naming a category that
+        // |catalog| lacks, which the core would refuse to start with. A leading
+        // "!" and an "@attribute" suffix are ignored; "ext:" files aren't checked.
+        inline bool geo_entry_exists(std::string_view entry, const GeoCatalog& catalog) {
+            if (entry.starts_with("geoip:")) {
+                std::string_view code = entry.substr(6);
+                if (code.starts_with('!')) code.remove_prefix(1);
+                return catalog.hasGeoip(code);
+            }
+            if (entry.starts_with("geosite:")) {
+                std::string_view code = entry.substr(8);
+                return catalog.hasGeosite(code.substr(0, code.find('@')));
+            }
             return true;
         }
-    } // namespace AngConfigManager
+
+        // |entries| without unknown geo categories; a plain copy without a catalog.
+        inline std::vector<std::string> prune_geo(const std::vector<std::string>& entries, const GeoCatalog* catalog) {
+            if (!catalog) return entries;
+            std::vector<std::string> kept;
+            kept.reserve(entries.size());
+            for (const auto& entry : entries) {
+                if (geo_entry_exists(entry, *catalog)) kept.push_back(entry);
+            }
+            return kept;
+        }
+    } // namespace RoutingRules
 
     // =================================================================================
     // Full V2Ray Config DTOs
@@ -531,37 +1914,141 @@ namespace V2rayConfigWin
             NLOHMANN_DEFINE_TYPE_INTRUSIVE(Inbound, tag, port, listen, protocol, sniffing, settings);
         };
 
+        // RoutingRule and Routing use explicit functions like Config below, so the
+        // balancer fields only appear in configs that use them.
         struct RoutingRule {
             std::string type = "field";
             std::optional<std::string> outboundTag;
+            std::optional<std::string> balancerTag;
             std::optional<std::vector<std::string>> inboundTag;
             std::optional<std::vector<std::string>> ip;
             std::optional<std::vector<std::string>> domain;
             std::optional<std::string> port;
-            NLOHMANN_DEFINE_TYPE_INTRUSIVE(RoutingRule, type, outboundTag, inboundTag, ip, domain, port);
+        };
+
+        inline void to_json(json& j, const RoutingRule& p) {
+            j = json{
+                {"type", p.type},
+                {"outboundTag", p.outboundTag},
+                {"inboundTag", p.inboundTag},
+                {"ip", p.ip},
+                {"domain", p.domain},
+                {"port", p.port}
+            };
+            if (p.balancerTag.has_value()) j["balancerTag"] = p.balancerTag;
+        }
+
+        inline void from_json(const json& j, RoutingRule& p) {
+            j.at("type").get_to(p.type);
+            j.at("outboundTag").get_to(p.outboundTag);
+            j.at("inboundTag").get_to(p.inboundTag);
+            j.at("ip").get_to(p.ip);
+            j.at("domain").get_to(p.domain);
+            j.at("port").get_to(p.port);
+            if (j.contains("balancerTag")) {
+                j.at("balancerTag").get_to(p.balancerTag);
+            }
+        }
+
+        struct BalancerStrategy {
+            std::string type = "leastPing";
+            NLOHMANN_DEFINE_TYPE_INTRUSIVE(BalancerStrategy, type);
+        };
+
+        // Picks one of the outbounds whose tag starts with a |selector| prefix,
+        // using the observatory's probe results for leastPing.
+        struct Balancer {
+            std::string tag;
+            std::vector<std::string> selector;
+            BalancerStrategy strategy;
+            NLOHMANN_DEFINE_TYPE_INTRUSIVE(Balancer, tag, selector, strategy);
         };
 
         struct Routing {
             std::string domainStrategy = "IPIfNonMatch";
             std::optional<std::string> domainMatcher = "mph";
             std::vector<RoutingRule> rules;
-            NLOHMANN_DEFINE_TYPE_INTRUSIVE(Routing, domainStrategy, domainMatcher, rules);
+            std::optional<std::vector<Balancer>> balancers;
+        };
+
+        inline void to_json(json& j, const Routing& p) {
+            j = json{
+                {"domainStrategy", p.domainStrategy},
+                {"domainMatcher", p.domainMatcher},
+                {"rules", p.rules}
+            };
+            if (p.balancers.has_value()) j["balancers"] = p.balancers;
+        }
+
+        inline void from_json(const json& j, Routing& p) {
+            j.at("domainStrategy").get_to(p.domainStrategy);
+            j.at("domainMatcher").get_to(p.domainMatcher);
+            j.at("rules").get_to(p.rules);
+            if (j.contains("balancers")) {
+                j.at("balancers").get_to(p.balancers);
+            }
+        }
+
+        // Background health checks: the core probes every outbound whose tag
+        // starts with a |subjectSelector| prefix and keeps the latest delay.
+        struct Observatory {
+            std::vector<std::string> subjectSelector;
+            std::string probeUrl = "https://www.gstatic.com/generate_204";
+            std::string probeInterval = "10s";
+            bool enableConcurrency = true;
+            NLOHMANN_DEFINE_TYPE_INTRUSIVE(Observatory, subjectSelector, probeUrl, probeInterval, enableConcurrency);
         };
 
+        // A DNS server that only answers for |domains|. With |skipFallback| it
+        // is not tried for other names once the pinned server fails to match.
         struct DnsServerObject {
             std::string address;
             int port = 53;
             std::optional<std::vector<std::string>> domains;
             std::optional<std::vector<std::string>> expectIPs;
-            NLOHMANN_DEFINE_TYPE_INTRUSIVE(DnsServerObject, address, port, domains, expectIPs);
+            std::optional<bool> skipFallback;
         };
 
+        inline void to_json(json& j, const DnsServerObject& p) {
+            j = json{ {"address", p.address}, {"port", p.port} };
+            if (p.domains.has_value()) j["domains"] = p.domains;
+            if (p.expectIPs.has_value()) j["expectIPs"] = p.expectIPs;
+            if (p.skipFallback.has_value()) j["skipFallback"] = p.skipFallback;
+        }
+
+        inline void from_json(const json& j, DnsServerObject& p) {
+            j.at("address").get_to(p.address);
+            if (j.contains("port")) j.at("port").get_to(p.port);
+            if (j.contains("domains")) j.at("domains").get_to(p.domains);
+            if (j.contains("expectIPs")) j.at("expectIPs").get_to(p.expectIPs);
+            if (j.contains("skipFallback")) j.at("skipFallback").get_to(p.skipFallback);
+        }
+
+        // |servers| mixes plain addresses and DnsServerObject objects, as the core
+        // accepts both. The resolver options are only written when set.
         struct Dns {
             std::optional<std::map<std::string, std::string>> hosts;
             std::optional<std::vector<json>> servers;
-            NLOHMANN_DEFINE_TYPE_INTRUSIVE(Dns, hosts, servers);
+            std::optional<std::string> queryStrategy;
+            std::optional<bool> disableCache;
+            std::optional<bool> disableFallbackIfMatch;
         };
 
+        inline void to_json(json& j, const Dns& p) {
+            j = json{ {"hosts", p.hosts}, {"servers", p.servers} };
+            if (p.queryStrategy.has_value()) j["queryStrategy"] = p.queryStrategy;
+            if (p.disableCache.has_value()) j["disableCache"] = p.disableCache;
+            if (p.disableFallbackIfMatch.has_value()) j["disableFallbackIfMatch"] = p.disableFallbackIfMatch;
+        }
+
+        inline void from_json(const json& j, Dns& p) {
+            j.at("hosts").get_to(p.hosts);
+            j.at("servers").get_to(p.servers);
+            if (j.contains("queryStrategy")) j.at("queryStrategy").get_to(p.queryStrategy);
+            if (j.contains("disableCache")) j.at("disableCache").get_to(p.disableCache);
+            if (j.contains("disableFallbackIfMatch")) j.at("disableFallbackIfMatch").get_to(p.disableFallbackIfMatch);
+        }
+
         struct Fakedns {
             std::string ipPool = "198.18.0.0/15";
             int poolSize = 65535;
@@ -578,6 +2065,7 @@ namespace V2rayConfigWin
             std::optional<json> stats;
             std::optional<json> policy;
             std::optional<std::vector<Fakedns>> fakedns;
+            std::optional<Observatory> observatory;
             // NLOHMANN_DEFINE_TYPE_INTRUSIVE macro removed from here.
         };
 
@@ -594,6 +2082,7 @@ namespace V2rayConfigWin
             if (p.stats.has_value()) j["stats"] = p.stats;
             if (p.policy.has_value()) j["policy"] = p.policy;
             if (p.fakedns.has_value()) j["fakedns"] = p.fakedns;
+            if (p.observatory.has_value()) j["observatory"] = p.observatory;
         }
 
         // Explicit deserialization function (JSON -> C++ object)
@@ -617,6 +2106,111 @@ namespace V2rayConfigWin
             if (j.contains("fakedns")) {
                 j.at("fakedns").get_to(p.fakedns);
             }
+            if (j.contains("observatory")) {
+                j.at("observatory").get_to(p.observatory);
+            }
+        }
+
+        // Direct serialization (C++ object -> JSON text) through JsonWriter,
+        // producing the same document as to_json above without the DOM. Members
+        // are written in sorted order and nullopt as null, as to_json does.
+        inline void write_json(JsonWriter& w, const Log& v) {
+            w.beginObject();
+            write_member(w, "loglevel", v.loglevel);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Sniffing& v) {
+            w.beginObject();
+            write_member(w, "destOverride", v.destOverride);
+            write_member(w, "enabled", v.enabled);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Inbound& v) {
+            w.beginObject();
+            write_member(w, "listen", v.listen);
+            write_member(w, "port", v.port);
+            write_member(w, "protocol", v.protocol);
+            write_member(w, "settings", v.settings);
+            write_member(w, "sniffing", v.sniffing);
+            write_member(w, "tag", v.tag);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const RoutingRule& v) {
+            w.beginObject();
+            if (v.balancerTag) write_member(w, "balancerTag", *v.balancerTag);
+            write_member(w, "domain", v.domain);
+            write_member(w, "inboundTag", v.inboundTag);
+            write_member(w, "ip", v.ip);
+            write_member(w, "outboundTag", v.outboundTag);
+            write_member(w, "port", v.port);
+            write_member(w, "type", v.type);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const BalancerStrategy& v) {
+            w.beginObject();
+            write_member(w, "type", v.type);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Balancer& v) {
+            w.beginObject();
+            write_member(w, "selector", v.selector);
+            write_member(w, "strategy", v.strategy);
+            write_member(w, "tag", v.tag);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Routing& v) {
+            w.beginObject();
+            if (v.balancers) write_member(w, "balancers", *v.balancers);
+            write_member(w, "domainMatcher", v.domainMatcher);
+            write_member(w, "domainStrategy", v.domainStrategy);
+            write_member(w, "rules", v.rules);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Dns& v) {
+            w.beginObject();
+            if (v.disableCache) write_member(w, "disableCache", *v.disableCache);
+            if (v.disableFallbackIfMatch) write_member(w, "disableFallbackIfMatch", *v.disableFallbackIfMatch);
+            write_member(w, "hosts", v.hosts);
+            if (v.queryStrategy) write_member(w, "queryStrategy", *v.queryStrategy);
+            write_member(w, "servers", v.servers);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Fakedns& v) {
+            w.beginObject();
+            write_member(w, "ipPool", v.ipPool);
+            write_member(w, "poolSize", v.poolSize);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Observatory& v) {
+            w.beginObject();
+            write_member(w, "enableConcurrency", v.enableConcurrency);
+            write_member(w, "probeInterval", v.probeInterval);
+            write_member(w, "probeUrl", v.probeUrl);
+            write_member(w, "subjectSelector", v.subjectSelector);
+            w.endObject();
+        }
+
+        inline void write_json(JsonWriter& w, const Config& v) {
+            w.beginObject();
+            if (v.dns) write_member(w, "dns", *v.dns);
+            if (v.fakedns) write_member(w, "fakedns", *v.fakedns);
+            write_member(w, "inbounds", v.inbounds);
+            write_member(w, "log", v.log);
+            if (v.observatory) write_member(w, "observatory", *v.observatory);
+            write_member(w, "outbounds", v.outbounds);
+            if (v.policy) write_member(w, "policy", *v.policy);
+            write_member(w, "routing", v.routing);
+            if (v.stats) write_member(w, "stats", *v.stats);
+            w.endObject();
         }
     }
 
@@ -627,9 +2221,13 @@ namespace V2rayConfigWin
         const std::string TAG_AGENT = "proxy";
         const std::string TAG_DIRECT = "direct";
         const std::string TAG_BLOCKED = "block";
+        const std::string TAG_BALANCER = "balancer";
+        const std::string TAG_DNS_IN = "dns-in";
+        const std::string TAG_DNS_OUT = "dns-out";
         const int PORT_SOCKS = 10808;
         const int PORT_HTTP = 10809;
         const int PORT_LOCAL_DNS = 10853;
+        const int PORT_OBSERVATORY_BASE = 20808;
     }
 
     enum class ERoutingMode { GLOBAL_PROXY, BYPASS_LAN, BYPASS_MAINLAND, BYPASS_LAN_MAINLAND, GLOBAL_DIRECT };
@@ -651,6 +2249,10 @@ namespace V2rayConfigWin
         std::string userRoutingAgent;   // Comma-separated rules
         std::string userRoutingDirect;  // Comma-separated rules
         std::string userRoutingBlocked; // Comma-separated rules
+        bool prettyPrint = false;       // Debug only: indented output for reading; the core doesn't need it
+        // Optional: geo rules naming categories missing from the geo files are
+        // dropped instead of failing core startup. Must outlive the settings.
+        const RoutingRules::GeoCatalog* geoCatalog = nullptr;
     };
 
 
@@ -700,210 +2302,800 @@ namespace V2rayConfigWin
                 }
             }
             
-            void routing_user_rule(const std::string& userRule, const std::string& tag, Config& v2rayConfig) {
+            void routing_user_rule(const std::string& userRule, const std::string& tag, Config& v2rayConfig,
+                                   const RoutingRules::GeoCatalog* catalog) {
                 if (userRule.empty()) return;
-                RoutingRule rulesDomain, rulesIP;
-                rulesDomain.outboundTag = tag;
-                rulesIP.outboundTag = tag;
-                rulesDomain.domain = std::vector<std::string>();
-                rulesIP.ip = std::vector<std::string>();
-
-                auto rules = Utils::split(userRule, ',');
-                for (const auto& rule : rules) {
-                    if (rule.empty()) continue;
-                    std::string trimmed_rule = std::regex_replace(rule, std::regex("^\\s+|\\s+$"), "");
-                    if (Utils::is_ip_address(trimmed_rule) || trimmed_rule.rfind("geoip:", 0) == 0) {
-                        rulesIP.ip->push_back(trimmed_rule);
-                    } else {
-                        rulesDomain.domain->push_back(trimmed_rule);
-                    }
+                // Parsed, deduplicated and CIDR-merged once per distinct rule text.
+                const auto compiled = RoutingRules::compile_cached(userRule);
+                if (auto domains = RoutingRules::prune_geo(compiled->domains, catalog); !domains.empty()) {
+                    RoutingRule rulesDomain;
+                    rulesDomain.outboundTag = tag;
+                    rulesDomain.domain = std::move(domains);
+                    v2rayConfig.routing.rules.push_back(std::move(rulesDomain));
+                }
+                if (auto ips = RoutingRules::prune_geo(compiled->ips, catalog); !ips.empty()) {
+                    RoutingRule rulesIP;
+                    rulesIP.outboundTag = tag;
+                    rulesIP.ip = std::move(ips);
+                    v2rayConfig.routing.rules.push_back(std::move(rulesIP));
                 }
-                if (rulesDomain.domain && !rulesDomain.domain->empty()) v2rayConfig.routing.rules.push_back(rulesDomain);
-                if (rulesIP.ip && !rulesIP.ip->empty()) v2rayConfig.routing.rules.push_back(rulesIP);
             }
 
-            void routing_geo(const std::string& ipOrDomain, const std::string& code, const std::string& tag, Config& v2rayConfig) {
+            // The rules a routing mode adds around the user rules: |front| goes
+            // ahead of every other rule, |back| after the user rules.
+            struct ModeRules {
+                std::vector<RoutingRule> front;
+                std::vector<RoutingRule> back;
+            };
+
+            void append_geo(std::vector<RoutingRule>& rules, const std::string& ipOrDomain, const std::string& code, const std::string& tag) {
                 if (code.empty()) return;
                 if (ipOrDomain == "ip" || ipOrDomain.empty()) {
                     RoutingRule rule;
                     rule.outboundTag = tag;
                     rule.ip = { "geoip:" + code };
-                    v2rayConfig.routing.rules.push_back(rule);
+                    rules.push_back(std::move(rule));
                 }
                 if (ipOrDomain == "domain" || ipOrDomain.empty()) {
                     RoutingRule rule;
                     rule.outboundTag = tag;
                     rule.domain = { "geosite:" + code };
-                    v2rayConfig.routing.rules.push_back(rule);
+                    rules.push_back(std::move(rule));
+                }
+            }
+
+            // Built once on first use and shared by every generate(); never
+            // modified afterwards. Unknown modes behave like GLOBAL_PROXY.
+            const ModeRules& mode_rules(ERoutingMode mode) {
+                static const std::array<ModeRules, 5> table = [] {
+                    std::array<ModeRules, 5> modes;
+                    RoutingRule googleapisRoute;
+                    googleapisRoute.outboundTag = TAG_AGENT;
+                    googleapisRoute.domain = { "domain:googleapis.cn" };
+
+                    auto& lan = modes[static_cast<size_t>(ERoutingMode::BYPASS_LAN)];
+                    append_geo(lan.back, "ip", "private", TAG_DIRECT);
+
+                    auto& mainland = modes[static_cast<size_t>(ERoutingMode::BYPASS_MAINLAND)];
+                    mainland.front.push_back(googleapisRoute);
+                    append_geo(mainland.back, "", "cn", TAG_DIRECT);
+
+                    auto& lanMainland = modes[static_cast<size_t>(ERoutingMode::BYPASS_LAN_MAINLAND)];
+                    lanMainland.front.push_back(googleapisRoute);
+                    append_geo(lanMainland.back, "ip", "private", TAG_DIRECT);
+                    append_geo(lanMainland.back, "", "cn", TAG_DIRECT);
+
+                    RoutingRule globalDirect;
+                    globalDirect.outboundTag = TAG_DIRECT;
+                    globalDirect.port = "0-65535";
+                    modes[static_cast<size_t>(ERoutingMode::GLOBAL_DIRECT)].back.push_back(std::move(globalDirect));
+                    return modes;
+                }();
+                static const ModeRules kNone;
+                const auto index = static_cast<size_t>(mode);
+                return index < table.size() ? table[index] : kNone;
+            }
+
+            // Inserts |block| at |pos|, leaving out rules whose geo category
+            // |catalog| lacks. Without a catalog the block goes in as is.
+            void insert_rules(std::vector<RoutingRule>& rules, std::vector<RoutingRule>::iterator pos,
+                              const std::vector<RoutingRule>& block, const RoutingRules::GeoCatalog* catalog) {
+                if (!catalog) {
+                    rules.insert(pos, block.begin(), block.end());
+                    return;
+                }
+                auto known = [catalog](const std::optional<std::vector<std::string>>& entries) {
+                    return !entries || std::all_of(entries->begin(), entries->end(),
+                                                   [catalog](const std::string& entry) { return RoutingRules::geo_entry_exists(entry, *catalog); });
+                };
+                std::vector<RoutingRule> kept;
+                for (const auto& rule : block) {
+                    if (known(rule.domain) && known(rule.ip)) kept.push_back(rule);
                 }
+                rules.insert(pos, std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()));
             }
 
             void apply_routing(Config& v2rayConfig, const V2rayGeneratorSettings& settings) {
-                routing_user_rule(settings.userRoutingAgent, TAG_AGENT, v2rayConfig);
-                routing_user_rule(settings.userRoutingDirect, TAG_DIRECT, v2rayConfig);
-                routing_user_rule(settings.userRoutingBlocked, TAG_BLOCKED, v2rayConfig);
+                const auto* catalog = settings.geoCatalog;
+                const ModeRules& mode = mode_rules(settings.routingMode);
+                auto& rules = v2rayConfig.routing.rules;
+                // Up to a domain and an ip rule per user list, plus the mode's blocks.
+                rules.reserve(rules.size() + 6 + mode.front.size() + mode.back.size());
+
+                routing_user_rule(settings.userRoutingAgent, TAG_AGENT, v2rayConfig, catalog);
+                routing_user_rule(settings.userRoutingDirect, TAG_DIRECT, v2rayConfig, catalog);
+                routing_user_rule(settings.userRoutingBlocked, TAG_BLOCKED, v2rayConfig, catalog);
 
                 v2rayConfig.routing.domainStrategy = settings.routingDomainStrategy;
-                
-                RoutingRule googleapisRoute;
-                googleapisRoute.outboundTag = TAG_AGENT;
-                googleapisRoute.domain = { "domain:googleapis.cn" };
-
-                switch (settings.routingMode) {
-                    case ERoutingMode::BYPASS_LAN:
-                        routing_geo("ip", "private", TAG_DIRECT, v2rayConfig);
-                        break;
-                    case ERoutingMode::BYPASS_MAINLAND:
-                        routing_geo("", "cn", TAG_DIRECT, v2rayConfig);
-                        v2rayConfig.routing.rules.insert(v2rayConfig.routing.rules.begin(), googleapisRoute);
-                        break;
-                    case ERoutingMode::BYPASS_LAN_MAINLAND:
-                        routing_geo("ip", "private", TAG_DIRECT, v2rayConfig);
-                        routing_geo("", "cn", TAG_DIRECT, v2rayConfig);
-                        v2rayConfig.routing.rules.insert(v2rayConfig.routing.rules.begin(), googleapisRoute);
-                        break;
-                    // FIX: Added curly braces to create a scope for the variable declaration
-                    case ERoutingMode::GLOBAL_DIRECT: {
-                        RoutingRule globalDirect;
-                        globalDirect.outboundTag = TAG_DIRECT;
-                        globalDirect.port = "0-65535";
-                        v2rayConfig.routing.rules.push_back(globalDirect);
-                        break;
-                    }
-                    case ERoutingMode::GLOBAL_PROXY:
-                    default:
-                        break;
-                }
-            }
-
-            // ... (dns and customLocalDns are complex and would be implemented here) ...
+
+                insert_rules(rules, rules.end(), mode.back, catalog);
+                if (!mode.front.empty()) insert_rules(rules, rules.begin(), mode.front, catalog);
+            }
+
+            // "geosite:" and "domain:" entries of a user rule list, which can be
+            // pinned to a DNS server; keywords, regexps and IPs can't.
+            std::vector<std::string> user_rule_domains(const std::string& userRule, const RoutingRules::GeoCatalog* catalog) {
+                std::vector<std::string> domains;
+                if (userRule.empty()) return domains;
+                for (const auto& domain : RoutingRules::compile_cached(userRule)->domains) {
+                    if (!(domain.starts_with("geosite:") || domain.starts_with("domain:"))) continue;
+                    if (catalog && !RoutingRules::geo_entry_exists(domain, *catalog)) continue;
+                    domains.push_back(domain);
+                }
+                return domains;
+            }
+
+            bool is_cn_routing_mode(ERoutingMode mode) {
+                return mode == ERoutingMode::BYPASS_MAINLAND || mode == ERoutingMode::BYPASS_LAN_MAINLAND;
+            }
+
+            // The dns section. Remote servers answer by default; domains routed
+            // direct (and geosite:cn in the mainland modes) are pinned to the
+            // domestic server without falling back to the remote ones. The core
+            // caches answers and queries A and AAAA in parallel (UseIP).
+            void apply_dns(Config& v2rayConfig, const V2rayGeneratorSettings& settings) {
+                const auto remoteDns = Utils::get_remote_dns_servers();
+                const auto domesticDns = Utils::get_domestic_dns_servers();
+                const auto* catalog = settings.geoCatalog;
+                const bool hasGeositeCn = !catalog || catalog->hasGeosite("cn");
+                const bool hasGeoipCn = !catalog || catalog->hasGeoip("cn");
+                Dns& dns = v2rayConfig.dns.emplace();
+                dns.queryStrategy = "UseIP";
+                dns.disableCache = false;
+                dns.disableFallbackIfMatch = true;
+
+                auto& servers = dns.servers.emplace();
+                if (settings.localDnsEnabled && settings.fakeDnsEnabled) {
+                    // Answered first, so fake IPs win for every domain we route.
+                    DnsServerObject fake;
+                    fake.address = "fakedns";
+                    fake.domains = std::vector<std::string>{};
+                    if (hasGeositeCn) fake.domains->push_back("geosite:cn");
+                    auto proxyDomains = user_rule_domains(settings.userRoutingAgent, catalog);
+                    auto directDomains = user_rule_domains(settings.userRoutingDirect, catalog);
+                    fake.domains->insert(fake.domains->end(), proxyDomains.begin(), proxyDomains.end());
+                    fake.domains->insert(fake.domains->end(), directDomains.begin(), directDomains.end());
+                    servers.push_back(fake);
+                }
+                servers.insert(servers.end(), remoteDns.begin(), remoteDns.end());
+
+                if (auto proxyDomains = user_rule_domains(settings.userRoutingAgent, catalog); !proxyDomains.empty() && !remoteDns.empty()) {
+                    DnsServerObject remote;
+                    remote.address = remoteDns.front();
+                    remote.domains = std::move(proxyDomains);
+                    servers.push_back(remote);
+                }
+                const bool cnMode = is_cn_routing_mode(settings.routingMode);
+                if (!domesticDns.empty()) {
+                    if (auto directDomains = user_rule_domains(settings.userRoutingDirect, catalog); !directDomains.empty()) {
+                        DnsServerObject domestic;
+                        domestic.address = domesticDns.front();
+                        domestic.domains = std::move(directDomains);
+                        if (cnMode && hasGeoipCn) domestic.expectIPs = std::vector<std::string>{ "geoip:cn" };
+                        domestic.skipFallback = true;
+                        servers.push_back(domestic);
+                    }
+                    if (cnMode && hasGeositeCn) {
+                        DnsServerObject domestic;
+                        domestic.address = domesticDns.front();
+                        domestic.domains = std::vector<std::string>{ "geosite:cn" };
+                        if (hasGeoipCn) domestic.expectIPs = std::vector<std::string>{ "geoip:cn" };
+                        domestic.skipFallback = true;
+                        servers.push_back(domestic);
+                    }
+                }
+
+                auto& hosts = dns.hosts.emplace();
+                for (const auto& domain : user_rule_domains(settings.userRoutingBlocked, catalog)) hosts[domain] = "127.0.0.1";
+                // Play Store fix carried over from v2rayNG.
+                hosts["domain:googleapis.cn"] = "googleapis.com";
+            }
+
+            // Rules in front of the user's: queries to the DNS servers themselves go
+            // out the way their answers are meant for, and the local DNS inbound is
+            // answered by the core's resolver.
+            void apply_dns_routing(Config& v2rayConfig, const V2rayGeneratorSettings& settings) {
+                const auto remoteDns = Utils::get_remote_dns_servers();
+                const auto domesticDns = Utils::get_domestic_dns_servers();
+                std::vector<RoutingRule> front;
+                if (settings.localDnsEnabled) {
+                    RoutingRule rule;
+                    rule.inboundTag = std::vector<std::string>{ TAG_DNS_IN };
+                    rule.outboundTag = TAG_DNS_OUT;
+                    front.push_back(std::move(rule));
+                }
+                if (!remoteDns.empty() && Utils::is_pure_ip_address(remoteDns.front())) {
+                    RoutingRule rule;
+                    rule.outboundTag = TAG_AGENT;
+                    rule.port = "53";
+                    rule.ip = std::vector<std::string>{ remoteDns.front() };
+                    front.push_back(std::move(rule));
+                }
+                if (!domesticDns.empty() && Utils::is_pure_ip_address(domesticDns.front())) {
+                    RoutingRule rule;
+                    rule.outboundTag = TAG_DIRECT;
+                    rule.port = "53";
+                    rule.ip = std::vector<std::string>{ domesticDns.front() };
+                    front.push_back(std::move(rule));
+                }
+                auto& rules = v2rayConfig.routing.rules;
+                rules.insert(rules.begin(), std::make_move_iterator(front.begin()), std::make_move_iterator(front.end()));
+            }
+
+            // With localDnsEnabled, a dokodemo-door inbound on localDnsPort hands
+            // plain DNS to the dns-out outbound.
+            void apply_local_dns_inbound(Config& v2rayConfig, const V2rayGeneratorSettings& settings) {
+                if (!settings.localDnsEnabled) return;
+                const auto remoteDns = Utils::get_remote_dns_servers();
+                const bool remoteIsIp = !remoteDns.empty() && Utils::is_pure_ip_address(remoteDns.front());
+                Inbound inbound;
+                inbound.tag = TAG_DNS_IN;
+                inbound.port = settings.localDnsPort;
+                inbound.protocol = "dokodemo-door";
+                inbound.settings = json{
+                    {"address", remoteIsIp ? remoteDns.front() : std::string("1.1.1.1")},
+                    {"network", "tcp,udp"},
+                    {"port", 53}
+                };
+                v2rayConfig.inbounds.push_back(std::move(inbound));
+            }
+
+            void apply_local_dns_outbound(Config& v2rayConfig, const V2rayGeneratorSettings& settings) {
+                if (!settings.localDnsEnabled) return;
+                v2rayConfig.outbounds.push_back(json{ {"protocol", "dns"}, {"tag", TAG_DNS_OUT} });
+            }
         }
 
-        // Main public function to generate the config
-        inline std::optional<std::string> generate(const ServerConfig& serverConfig, const V2rayGeneratorSettings& settings) {
+        // Template every generated config starts from.
+        inline constexpr const char* kBaseConfigTemplate = R"({
+        "stats":{},
+        "log": {
+            "loglevel": "warning"
+        },
+        "policy":{
+            "levels": {
+                "8": {
+                "handshake": 4,
+                "connIdle": 300,
+                "uplinkOnly": 1,
+                "downlinkOnly": 1
+                }
+            },
+            "system": {
+                "statsOutboundUplink": true,
+                "statsOutboundDownlink": true
+            }
+        },
+        "inbounds": [{
+            "tag": "socks",
+            "port": 10808,
+            "listen": "127.0.0.1",
+            "protocol": "socks",
+            "settings": {
+            "auth": "noauth",
+            "udp": true,
+            "userLevel": 8
+            },
+            "sniffing": {
+            "enabled": true,
+            "destOverride": [
+                "http",
+                "tls"
+            ]
+            }
+        },
+        {
+            "tag": "http",
+            "port": 10809,
+            "listen": "127.0.0.1",
+            "protocol": "http",
+            "settings": {
+            "userLevel": 8
+            },
+            "sniffing": {
+            "enabled": true,
+            "destOverride": [
+                "http",
+                "tls"
+            ]
+            }
+        }
+        ],
+        "outbounds": [
+        {
+            "protocol": "freedom",
+            "settings": {},
+            "tag": "direct"
+        },
+        {
+            "protocol": "blackhole",
+            "tag": "block",
+            "settings": {
+            "response": {
+                "type": "http"
+            }
+            }
+        }
+        ],
+        "routing": {
+            "domainStrategy": "IPIfNonMatch",
+            "domainMatcher": "mph",
+            "rules": []
+        },
+        "dns": {
+            "hosts": {},
+            "servers": []
+        }
+        }
+        )";
+
+        namespace detail {
+            // kBaseConfigTemplate parsed on first use and shared read-only after
+            // that; generate() copies it instead of re-parsing the literal on every
+            // connect and every ping config. Static initialization is thread-safe,
+            // and a throw here is retried on the next call.
+            inline const Config& base_config() {
+                static const Config base = json::parse(kBaseConfigTemplate).get<Config>();
+                return base;
+            }
+        }
+
+        namespace detail {
+            // What generate() builds, split by the settings that feed it. Each stage
+            // rebuilds its sections from the base template rather than editing them
+            // in place, so re-running any subset on an earlier result yields the
+            // same Config as a full build.
+            inline constexpr unsigned kStageLog = 1u << 0;       // logLevel
+            inline constexpr unsigned kStageInbounds = 1u << 1;  // ports, proxySharing, sniffing, fakeDnsEnabled, local DNS
+            inline constexpr unsigned kStageOutbounds = 1u << 2; // fakeDnsEnabled (fakedns section, freedom outbounds), local DNS
+            inline constexpr unsigned kStageRouting = 1u << 3;   // routing mode, domain strategy, user rules, local DNS
+            inline constexpr unsigned kStageStats = 1u << 4;     // speedEnabled: stats and policy
+            inline constexpr unsigned kStageDns = 1u << 5;       // routing mode, user rules, fakeDnsEnabled, local DNS
+            inline constexpr unsigned kAllStages = (1u << 6) - 1;
+
+            // Stages whose output differs between |before| and |after|.
+            inline unsigned changed_stages(const V2rayGeneratorSettings& before, const V2rayGeneratorSettings& after) {
+                unsigned stages = 0;
+                const bool localDns = before.localDnsEnabled != after.localDnsEnabled;
+                // A different catalog can prune different geo rules.
+                const bool userRules = before.userRoutingAgent != after.userRoutingAgent ||
+                                       before.userRoutingDirect != after.userRoutingDirect ||
+                                       before.userRoutingBlocked != after.userRoutingBlocked ||
+                                       before.geoCatalog != after.geoCatalog;
+                if (before.logLevel != after.logLevel) stages |= kStageLog;
+                if (before.socksPort != after.socksPort || before.httpPort != after.httpPort ||
+                    before.proxySharing != after.proxySharing || before.sniffingEnabled != after.sniffingEnabled ||
+                    before.fakeDnsEnabled != after.fakeDnsEnabled || localDns ||
+                    (after.localDnsEnabled && before.localDnsPort != after.localDnsPort)) {
+                    stages |= kStageInbounds;
+                }
+                if (before.fakeDnsEnabled != after.fakeDnsEnabled || localDns) stages |= kStageOutbounds;
+                if (before.routingMode != after.routingMode || before.routingDomainStrategy != after.routingDomainStrategy ||
+                    userRules || localDns) {
+                    stages |= kStageRouting;
+                }
+                if (before.speedEnabled != after.speedEnabled) stages |= kStageStats;
+                if (before.routingMode != after.routingMode || userRules || before.fakeDnsEnabled != after.fakeDnsEnabled || localDns) {
+                    stages |= kStageDns;
+                }
+                return stages;
+            }
+
+            // Re-runs |stages| on |v2rayConfig|, with |proxyOutbounds| as the
+            // untouched proxy outbounds that go in front of the template's.
+            inline void apply_stages(Config& v2rayConfig, std::vector<json> proxyOutbounds, const V2rayGeneratorSettings& settings, unsigned stages) {
+                const Config& base = base_config();
+                if (stages & kStageLog) {
+                    v2rayConfig.log = base.log;
+                    v2rayConfig.log.loglevel = settings.logLevel;
+                }
+                if (stages & kStageInbounds) {
+                    v2rayConfig.inbounds = base.inbounds;
+                    apply_inbounds_settings(v2rayConfig, settings);
+                    apply_local_dns_inbound(v2rayConfig, settings);
+                }
+                if (stages & kStageOutbounds) {
+                    // Proxy outbounds first, then the template's direct and block.
+                    v2rayConfig.outbounds = std::move(proxyOutbounds);
+                    v2rayConfig.outbounds.insert(v2rayConfig.outbounds.end(), base.outbounds.begin(), base.outbounds.end());
+                    v2rayConfig.fakedns = base.fakedns;
+                    apply_fakedns(v2rayConfig, settings);
+                    apply_local_dns_outbound(v2rayConfig, settings);
+                }
+                if (stages & kStageRouting) {
+                    v2rayConfig.routing = base.routing;
+                    apply_routing(v2rayConfig, settings);
+                    apply_dns_routing(v2rayConfig, settings);
+                }
+                if (stages & kStageDns) {
+                    apply_dns(v2rayConfig, settings);
+                }
+                if (stages & kStageStats) {
+                    if (settings.speedEnabled) {
+                        v2rayConfig.stats = base.stats;
+                        v2rayConfig.policy = base.policy;
+                    } else {
+                        v2rayConfig.stats = nullptr;
+                        v2rayConfig.policy = nullptr;
+                    }
+                }
+            }
+
+            // Everything generate() does before serializing: the base template with
+            // |settings| applied and |proxyOutbounds| at the front of outbounds.
+            inline Config build_config(const V2rayGeneratorSettings& settings, std::vector<json> proxyOutbounds) {
+                Config v2rayConfig;
+                apply_stages(v2rayConfig, std::move(proxyOutbounds), settings, kAllStages);
+                return v2rayConfig;
+            }
+
+            inline Config build_config(const V2rayGeneratorSettings& settings, json proxyOutbound) {
+                std::vector<json> proxyOutbounds;
+                proxyOutbounds.push_back(std::move(proxyOutbound));
+                return build_config(settings, std::move(proxyOutbounds));
+            }
+
+            // Servers whose config can't be spliced from a ConfigTemplate: custom
+            // configs, and freedom outbounds that apply_fakedns would rewrite.
+            inline bool needs_full_generate(const ServerConfig& serverConfig, const V2rayGeneratorSettings& settings) {
+                return serverConfig.configType == EConfigType::CUSTOM ||
+                       (settings.fakeDnsEnabled && serverConfig.outboundBean && serverConfig.outboundBean->protocol == "freedom");
+            }
+        }
+
+        // Generates the core config for |serverConfig| into |out|, replacing its
+        // contents but keeping its capacity, so callers generating many configs
+        // can reuse one buffer. Returns false (and logs) on failure.
+        inline bool generate_into(const ServerConfig& serverConfig, const V2rayGeneratorSettings& settings, std::string& out) {
+            out.clear();
             try {
                 if (serverConfig.configType == EConfigType::CUSTOM) {
                     // For custom configs, we assume the full config is already provided.
                     // This part of the logic would need to be adapted based on how you store custom configs.
-                    return "{\"error\":\"Custom config generation not implemented in this translation.\"}";
-                }
-
-                // 1. Load the base config from an embedded string
-                const char* base_config_str = R"({
-                "stats":{},
-                "log": {
-                    "loglevel": "warning"
-                },
-                "policy":{
-                    "levels": {
-                        "8": {
-                        "handshake": 4,
-                        "connIdle": 300,
-                        "uplinkOnly": 1,
-                        "downlinkOnly": 1
-                        }
-                    },
-                    "system": {
-                        "statsOutboundUplink": true,
-                        "statsOutboundDownlink": true
-                    }
-                },
-                "inbounds": [{
-                    "tag": "socks",
-                    "port": 10808,
-                    "listen": "127.0.0.1",
-                    "protocol": "socks",
-                    "settings": {
-                    "auth": "noauth",
-                    "udp": true,
-                    "userLevel": 8
-                    },
-                    "sniffing": {
-                    "enabled": true,
-                    "destOverride": [
-                        "http",
-                        "tls"
-                    ]
-                    }
-                },
-                {
-                    "tag": "http",
-                    "port": 10809,
-                    "listen": "127.0.0.1",
-                    "protocol": "http",
-                    "settings": {
-                    "userLevel": 8
-                    },
-                    "sniffing": {
-                    "enabled": true,
-                    "destOverride": [
-                        "http",
-                        "tls"
-                    ]
-                    }
-                }
-                ],
-                "outbounds": [
-                {
-                    "protocol": "freedom",
-                    "settings": {},
-                    "tag": "direct"
-                },
-                {
-                    "protocol": "blackhole",
-                    "tag": "block",
-                    "settings": {
-                    "response": {
-                        "type": "http"
-                    }
-                    }
-                }
-                ],
-                "routing": {
-                    "domainStrategy": "IPIfNonMatch",
-                    "domainMatcher": "mph",
-                    "rules": []
-                },
-                "dns": {
-                    "hosts": {},
-                    "servers": []
-                }
-                }
-                )";
-                json v2ray_json = json::parse(base_config_str);
-                Config v2rayConfig = v2ray_json.get<Config>();
-               // [json.exception.out_of_range.403] key 'loglevel' not found
-                // 2. Set log level
-                v2rayConfig.log.loglevel = settings.logLevel;
-
-                // 3. Apply inbound settings
-                apply_inbounds_settings(v2rayConfig, settings);
-
-                // 4. Prepare the main proxy outbound
+                    out = "{\"error\":\"Custom config generation not implemented in this translation.\"}";
+                    return true;
+                }
+
+                // Prepare the main proxy outbound
                 json outbound_proxy = serverConfig.outboundBean; // Use nlohmann's automatic conversion
                 outbound_proxy["tag"] = TAG_AGENT;
-                v2rayConfig.outbounds.insert(v2rayConfig.outbounds.begin(), outbound_proxy);
+                Config v2rayConfig = detail::build_config(settings, std::move(outbound_proxy));
+
+                // Serialize straight into the output buffer; compact unless debugging
+                JsonWriter writer(out, settings.prettyPrint ? 2 : -1);
+                write_json(writer, v2rayConfig);
+                return true;
+
+            } catch (const std::exception& e) {
+                std::cerr << "Error generating V2Ray config: " << e.what() << std::endl;
+                out.clear();
+                return false;
+            }
+        }
+
+        // Main public function to generate the config
+        inline std::optional<std::string> generate(const ServerConfig& serverConfig, const V2rayGeneratorSettings& settings) {
+            std::string out;
+            if (!generate_into(serverConfig, settings, out)) return std::nullopt;
+            return out;
+        }
+
+        // Remembers the Config behind the last generated output so that a settings
+        // change only re-runs the stages it affects (see detail::changed_stages)
+        // before reserializing. Output always matches generate() for the same
+        // server and settings. Not synchronized.
+        class IncrementalGenerator {
+        public:
+            // Generates for |serverConfig|. If it is the server of the previous
+            // call, only the stages changed by |settings| are re-applied.
+            std::optional<std::string> generate(const ServerConfig& serverConfig, const V2rayGeneratorSettings& settings) {
+                try {
+                    if (serverConfig.configType == EConfigType::CUSTOM) {
+                        reset();
+                        return V2rayConfigGenerator::generate(serverConfig, settings);
+                    }
+                    json outbound_proxy = serverConfig.outboundBean;
+                    outbound_proxy["tag"] = TAG_AGENT;
+                    if (m_config && m_proxyOutbounds.size() == 1 && m_proxyOutbounds.front() == outbound_proxy) {
+                        return update(settings);
+                    }
+
+                    m_proxyOutbounds.clear();
+                    m_proxyOutbounds.push_back(std::move(outbound_proxy));
+                    m_config = detail::build_config(settings, m_proxyOutbounds);
+                    m_settings = settings;
+                    m_catalogFingerprint = catalog_fingerprint(settings);
+                    m_lastStages = detail::kAllStages;
+                    return serialize();
+                } catch (const std::exception& e) {
+                    std::cerr << "Error generating V2Ray config: " << e.what() << std::endl;
+                    reset();
+                    return std::nullopt;
+                }
+            }
+
+            // Re-generates the last server's config under |settings|. Returns
+            // nullopt if nothing has been generated yet.
+            std::optional<std::string> update(const V2rayGeneratorSettings& settings) {
+                if (!m_config) return std::nullopt;
+                try {
+                    m_lastStages = detail::changed_stages(m_settings, settings);
+                    // changed_stages compares catalogs by address, which misses one
+                    // reloaded in place or a new one at a reused address.
+                    const uint64_t catalog = catalog_fingerprint(settings);
+                    if (catalog != m_catalogFingerprint) m_lastStages |= detail::kStageRouting | detail::kStageDns;
+                    if (m_lastStages) detail::apply_stages(*m_config, m_proxyOutbounds, settings, m_lastStages);
+                    m_settings = settings;
+                    m_catalogFingerprint = catalog;
+                    return serialize();
+                } catch (const std::exception& e) {
+                    std::cerr << "Error updating V2Ray config: " << e.what() << std::endl;
+                    reset();
+                    return std::nullopt;
+                }
+            }
+
+            bool hasConfig() const { return m_config.has_value(); }
+            // detail::kStage* bits re-run by the last call.
+            unsigned lastStages() const { return m_lastStages; }
+
+            void reset() {
+                m_config.reset();
+                m_proxyOutbounds.clear();
+                m_lastStages = 0;
+            }
+
+        private:
+            static uint64_t catalog_fingerprint(const V2rayGeneratorSettings& settings) {
+                return settings.geoCatalog ? settings.geoCatalog->fingerprint() : 0;
+            }
+
+            std::string serialize() const {
+                std::string out;
+                JsonWriter writer(out, m_settings.prettyPrint ? 2 : -1);
+                write_json(writer, *m_config);
+                return out;
+            }
+
+            std::optional<Config> m_config;
+            std::vector<json> m_proxyOutbounds; // as inserted, before apply_fakedns
+            V2rayGeneratorSettings m_settings;
+            uint64_t m_catalogFingerprint = 0; // of m_settings.geoCatalog when last applied
+            unsigned m_lastStages = 0;
+        };
+
+        // The server-independent text of a compact generated config: everything
+        // before and after the proxy outbound at outbounds[0].
+        struct ConfigTemplate {
+            std::string prefix;
+            std::string suffix;
+        };
+
+        inline std::optional<ConfigTemplate> build_template(const V2rayGeneratorSettings& settings) {
+            // A string stands in for the outbound; apply_fakedns only rewrites objects.
+            static constexpr std::string_view kPlaceholder = "\x01proxy-outbound\x01";
+            static constexpr std::string_view kPlaceholderJson = "\"\\u0001proxy-outbound\\u0001\"";
+            Config config = detail::build_config(settings, json(std::string(kPlaceholder)));
+            std::string text;
+            JsonWriter writer(text);
+            write_json(writer, config);
+
+            const size_t at = text.find(kPlaceholderJson);
+            if (at == std::string::npos || text.find(kPlaceholderJson, at + 1) != std::string::npos) {
+                return std::nullopt;
+            }
+            return ConfigTemplate{ text.substr(0, at), text.substr(at + kPlaceholderJson.size()) };
+        }
+
+        // Generates compact configs for many servers sharing |settings|, as for
+        // ping testing or failover. The prefix and suffix are rendered once;
+        // each config is then the prefix, the server's outbound written straight
+        // from its OutboundBean, and the suffix, built in a single allocation.
+        // Servers are spread over |threads| threads (0 = one per hardware thread).
+        //
+        // Entries match generate() byte for byte, including nullopt where it
+        // fails. With settings.prettyPrint every server goes through generate().
+        inline std::vector<std::optional<std::string>> generate_batch(const std::vector<ServerConfig>& servers, const V2rayGeneratorSettings& settings,
+                                                                      size_t threads = 0) {
+            std::vector<std::optional<std::string>> configs(servers.size());
+            std::optional<ConfigTemplate> shared;
+            if (!settings.prettyPrint) {
+                try {
+                    shared = build_template(settings);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error building V2Ray config template: " << e.what() << std::endl;
+                }
+            }
+
+            Utils::parallel_chunks(servers.size(), threads, 16, [&](size_t begin, size_t end) {
+                std::string outbound;
+                for (size_t i = begin; i < end; ++i) {
+                    const ServerConfig& server = servers[i];
+                    if (!shared || detail::needs_full_generate(server, settings)) {
+                        configs[i] = generate(server, settings);
+                        continue;
+                    }
+
+                    outbound.clear();
+                    JsonWriter writer(outbound);
+                    if (server.outboundBean) {
+                        V2rayConfig::write_outbound(writer, *server.outboundBean, TAG_AGENT);
+                    } else {
+                        writer.beginObject();
+                        writer.key("tag");
+                        writer.string(TAG_AGENT);
+                        writer.endObject();
+                    }
+
+                    std::string& config = configs[i].emplace();
+                    config.reserve(shared->prefix.size() + outbound.size() + shared->suffix.size());
+                    config += shared->prefix;
+                    config += outbound;
+                    config += shared->suffix;
+                }
+            });
+            return configs;
+        }
+
+        // How generate_observatory() exposes each server's outbound.
+        enum class EObservatoryRouting {
+            PER_INBOUND_PORT, // server i gets its own socks inbound on basePort + i
+            BALANCER          // the regular inbounds feed a leastPing balancer over all servers
+        };
+
+        struct ObservatoryOptions {
+            EObservatoryRouting routing = EObservatoryRouting::PER_INBOUND_PORT;
+            int basePort = PORT_OBSERVATORY_BASE;
+            std::string probeUrl = "https://www.gstatic.com/generate_204";
+            std::string probeInterval = "10s";
+        };
 
-                // 5. Apply routing, DNS, etc.
-                apply_routing(v2rayConfig, settings);
-                apply_fakedns(v2rayConfig, settings);
-                // Note: Full DNS and customLocalDns logic is complex and omitted for brevity,
-                // but would be called here.
+        struct ObservatoryConfig {
+            std::string config;
+            std::vector<std::string> outboundTags; // per input server; empty if it was skipped
+            std::vector<int> ports;                // per input server in PER_INBOUND_PORT mode, else 0
+        };
+
+        // Generates one config carrying every server in |servers| as its own
+        // outbound, tagged "proxy-<index>", plus an observatory probing all of
+        // them, so a single core instance can measure N servers instead of
+        // starting N instances.
+        //
+        // In PER_INBOUND_PORT mode server i is reachable through a socks inbound
+        // on options.basePort + i that routes straight to its outbound; the user
+        // routing rules are left out so every probe goes through the proxy. In
+        // BALANCER mode the usual socks/http inbounds and routing are kept, with
+        // rules to the proxy sent to a leastPing balancer instead.
+        //
+        // Custom configs and servers without an outbound are skipped. Returns
+        // nullopt (and logs) if nothing is left or the ports don't fit.
+        inline std::optional<ObservatoryConfig> generate_observatory(const std::vector<ServerConfig>& servers, const V2rayGeneratorSettings& settings,
+                                                                     const ObservatoryOptions& options = {}) {
+            const bool perPort = options.routing == EObservatoryRouting::PER_INBOUND_PORT;
+            if (perPort && (options.basePort <= 0 || options.basePort + static_cast<long long>(servers.size()) - 1 > 65535)) {
+                std::cerr << "Error generating observatory config: ports " << options.basePort << "+" << servers.size()
+                          << " out of range" << std::endl;
+                return std::nullopt;
+            }
+
+            try {
+                ObservatoryConfig result;
+                result.outboundTags.resize(servers.size());
+                result.ports.resize(servers.size());
+                const std::string prefix = TAG_AGENT + "-";
+
+                std::vector<json> proxyOutbounds;
+                proxyOutbounds.reserve(servers.size());
+                for (size_t i = 0; i < servers.size(); ++i) {
+                    const ServerConfig& server = servers[i];
+                    if (server.configType == EConfigType::CUSTOM || !server.outboundBean) continue;
+                    std::string tag = prefix + std::to_string(i);
+                    json outbound = *server.outboundBean;
+                    outbound["tag"] = tag;
+                    proxyOutbounds.push_back(std::move(outbound));
+                    result.outboundTags[i] = std::move(tag);
+                }
+                if (proxyOutbounds.empty()) {
+                    std::cerr << "Error generating observatory config: no usable servers" << std::endl;
+                    return std::nullopt;
+                }
 
-                // 6. Handle stats/policy
-                if (!settings.speedEnabled) {
-                    v2rayConfig.stats = nullptr;
-                    v2rayConfig.policy = nullptr;
+                Config v2rayConfig = detail::build_config(settings, std::move(proxyOutbounds));
+                auto& rules = v2rayConfig.routing.rules;
+                if (perPort) {
+                    // The socks inbound, with settings applied, is the prototype for
+                    // every per-server inbound.
+                    const Inbound socks = v2rayConfig.inbounds.front();
+                    v2rayConfig.inbounds.clear();
+                    rules.clear();
+                    for (size_t i = 0; i < servers.size(); ++i) {
+                        if (result.outboundTags[i].empty()) continue;
+                        Inbound& inbound = v2rayConfig.inbounds.emplace_back(socks);
+                        inbound.tag = socks.tag + "-" + std::to_string(i);
+                        inbound.port = options.basePort + static_cast<int>(i);
+                        result.ports[i] = inbound.port;
+
+                        RoutingRule rule;
+                        rule.inboundTag = std::vector<std::string>{ inbound.tag };
+                        rule.outboundTag = result.outboundTags[i];
+                        rules.push_back(std::move(rule));
+                    }
+                } else {
+                    for (auto& rule : rules) {
+                        if (rule.outboundTag == TAG_AGENT) {
+                            rule.outboundTag.reset();
+                            rule.balancerTag = TAG_BALANCER;
+                        }
+                    }
+                    // Whatever no other rule claims goes to the balancer rather than
+                    // to the first outbound.
+                    RoutingRule fallback;
+                    fallback.balancerTag = TAG_BALANCER;
+                    fallback.inboundTag = std::vector<std::string>{};
+                    for (const auto& inbound : v2rayConfig.inbounds) fallback.inboundTag->push_back(inbound.tag);
+                    rules.push_back(std::move(fallback));
+
+                    Balancer balancer;
+                    balancer.tag = TAG_BALANCER;
+                    balancer.selector = { prefix };
+                    v2rayConfig.routing.balancers = std::vector<Balancer>{ std::move(balancer) };
                 }
 
-                // 7. Serialize to string
-                return json(v2rayConfig).dump(2); // 2-space indentation
+                Observatory observatory;
+                observatory.subjectSelector = { prefix };
+                observatory.probeUrl = options.probeUrl;
+                observatory.probeInterval = options.probeInterval;
+                v2rayConfig.observatory = std::move(observatory);
+
+                JsonWriter writer(result.config, settings.prettyPrint ? 2 : -1);
+                write_json(writer, v2rayConfig);
+                return result;
 
             } catch (const std::exception& e) {
-                std::cerr << "Error generating V2Ray config: " << e.what() << std::endl;
+                std::cerr << "Error generating observatory config: " << e.what() << std::endl;
                 return std::nullopt;
             }
         }
+
+        // Every geoip:/geosite: entry generate() would emit under |settings| that
+        // |catalog| doesn't have, in config order, each once. Empty means the
+        // core will find all of them; settings.geoCatalog is ignored.
+        inline std::vector<std::string> find_unknown_geo_rules(const V2rayGeneratorSettings& settings, const RoutingRules::GeoCatalog& catalog) {
+            V2rayGeneratorSettings unpruned = settings;
+            unpruned.geoCatalog = nullptr;
+            const Config v2rayConfig = detail::build_config(unpruned, std::vector<json>{});
+
+            std::vector<std::string> unknown;
+            std::unordered_set<std::string> seen;
+            auto check = [&](const std::string& entry) {
+                if (!RoutingRules::geo_entry_exists(entry, catalog) && seen.insert(entry).second) unknown.push_back(entry);
+            };
+            auto check_all = [&](const std::optional<std::vector<std::string>>& entries) {
+                if (entries) for (const auto& entry : *entries) check(entry);
+            };
+            for (const auto& rule : v2rayConfig.routing.rules) {
+                check_all(rule.domain);
+                check_all(rule.ip);
+            }
+            if (v2rayConfig.dns) {
+                if (v2rayConfig.dns->servers) {
+                    for (const auto& server : *v2rayConfig.dns->servers) {
+                        if (!server.is_object()) continue;
+                        for (const char* field : { "domains", "expectIPs" }) {
+                            auto it = server.find(field);
+                            if (it == server.end() || !it->is_array()) continue;
+                            for (const auto& entry : *it) {
+                                if (entry.is_string()) check(entry.get_ref<const std::string&>());
+                            }
+                        }
+                    }
+                }
+                if (v2rayConfig.dns->hosts) {
+                    for (const auto& [domain, address] : *v2rayConfig.dns->hosts) check(domain);
+                }
+            }
+            return unknown;
+        }
     } // namespace V2rayConfigGenerator
 
 } // namespace V2rayConfigWin
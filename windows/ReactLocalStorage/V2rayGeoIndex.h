@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "V2rayConfigWin.h"
+
+// =================================================================================
+// Geo data index
+// =================================================================================
+namespace V2rayConfigWin
+{
+    namespace detail {
+        // A read-only view of a whole file, mapped rather than read so that
+        // indexing a multi-megabyte geosite.dat touches only the bytes it needs.
+        class MappedFile {
+        public:
+            MappedFile() = default;
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+            MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+            MappedFile& operator=(MappedFile&& other) noexcept {
+                if (this != &other) {
+                    close();
+                    m_data = std::exchange(other.m_data, nullptr);
+                    m_size = std::exchange(other.m_size, 0);
+                }
+                return *this;
+            }
+            ~MappedFile() { close(); }
+
+            bool open(const std::filesystem::path& path) {
+                close();
+#ifdef _WIN32
+                HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) return false;
+                LARGE_INTEGER size{};
+                if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+                    CloseHandle(file);
+                    return false;
+                }
+                HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                CloseHandle(file);
+                if (!mapping) return false;
+                void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                CloseHandle(mapping); // the view keeps the mapping alive
+                if (!view) return false;
+                m_data = static_cast<const char*>(view);
+                m_size = static_cast<size_t>(size.QuadPart);
+#else
+                const int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) return false;
+                struct stat info {};
+                if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+                    ::close(fd);
+                    return false;
+                }
+                void* view = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd);
+                if (view == MAP_FAILED) return false;
+                m_data = static_cast<const char*>(view);
+                m_size = static_cast<size_t>(info.st_size);
+#endif
+                return true;
+            }
+
+            void close() {
+                if (!m_data) return;
+#ifdef _WIN32
+                UnmapViewOfFile(m_data);
+#else
+                ::munmap(const_cast<char*>(m_data), m_size);
+#endif
+                m_data = nullptr;
+                m_size = 0;
+            }
+
+            bool isOpen() const { return m_data != nullptr; }
+            std::string_view view() const { return { m_data, m_size }; }
+
+        private:
+            const char* m_data = nullptr;
+            size_t m_size = 0;
+        };
+
+        // Just enough protobuf wire format to walk GeoIPList and GeoSiteList.
+        inline bool read_varint(std::string_view data, size_t& pos, uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+                const uint8_t byte = static_cast<uint8_t>(data[pos++]);
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return true;
+            }
+            return false;
+        }
+
+        // Moves past the value of a field whose key has already been read.
+        inline bool skip_field(std::string_view data, size_t& pos, uint32_t wireType) {
+            uint64_t value = 0;
+            switch (wireType) {
+                case 0: return read_varint(data, pos, value);
+                case 1: if (data.size() - pos < 8) return false; pos += 8; return true;
+                case 2:
+                    if (!read_varint(data, pos, value) || value > data.size() - pos) return false;
+                    pos += static_cast<size_t>(value);
+                    return true;
+                case 5: if (data.size() - pos < 4) return false; pos += 4; return true;
+                default: return false;
+            }
+        }
+
+        // Calls |visit|(code, entry) for every top-level `repeated entry = 1` of
+        // a GeoIPList or GeoSiteList, where |code| is the entry's country_code
+        // (field 1) and |entry| its serialized bytes. Returns false on a
+        // malformed file; entries already visited stay visited.
+        template <typename Visit>
+        inline bool for_each_geo_entry(std::string_view data, Visit&& visit) {
+            size_t pos = 0;
+            while (pos < data.size()) {
+                uint64_t key = 0, length = 0;
+                if (!read_varint(data, pos, key)) return false;
+                if ((key & 7) != 2 || (key >> 3) != 1) {
+                    if (!skip_field(data, pos, static_cast<uint32_t>(key & 7))) return false;
+                    continue;
+                }
+                if (!read_varint(data, pos, length) || length > data.size() - pos) return false;
+                const std::string_view entry = data.substr(pos, static_cast<size_t>(length));
+                pos += static_cast<size_t>(length);
+
+                std::string_view code;
+                size_t at = 0;
+                while (at < entry.size()) {
+                    uint64_t fieldKey = 0;
+                    if (!read_varint(entry, at, fieldKey)) return false;
+                    if (fieldKey == ((1 << 3) | 2)) {
+                        uint64_t codeLength = 0;
+                        if (!read_varint(entry, at, codeLength) || codeLength > entry.size() - at) return false;
+                        code = entry.substr(at, static_cast<size_t>(codeLength));
+                        break;
+                    }
+                    if (!skip_field(entry, at, static_cast<uint32_t>(fieldKey & 7))) return false;
+                }
+                visit(code, entry);
+            }
+            return true;
+        }
+    } // namespace detail
+
+    // Category codes of the core's geoip.dat and geosite.dat, for checking
+    // geo rules before the core is started with them. Each file is mapped just
+    // long enough to index it by lowercased code, so nothing keeps it open or
+    // locked afterwards; stale() tells when it has been replaced since. A file
+    // that isn't loaded accepts every code, so a missing geosite.dat never
+    // prunes rules the core might still resolve. Not synchronized; load before
+    // sharing.
+    class GeoIndex : public RoutingRules::GeoCatalog {
+    public:
+        // Loads geoip.dat and geosite.dat from |directory|; true if either loaded.
+        bool open(const std::filesystem::path& directory) {
+            const bool geoip = openGeoip(directory / "geoip.dat");
+            const bool geosite = openGeosite(directory / "geosite.dat");
+            return geoip || geosite;
+        }
+
+        bool openGeoip(const std::filesystem::path& path) { return load(path, m_geoip); }
+        bool openGeosite(const std::filesystem::path& path) { return load(path, m_geosite); }
+
+        // True if either file was created, removed or rewritten (size or write
+        // time) since it was opened. Only files opened through this index count.
+        bool stale() const { return changed(m_geoip) || changed(m_geosite); }
+
+        bool hasGeoip(std::string_view code) const override { return contains(m_geoip, code); }
+        bool hasGeosite(std::string_view code) const override { return contains(m_geosite, code); }
+
+        uint64_t fingerprint() const override {
+            return Utils::murmur3_128(std::to_string(m_geoip.fingerprint) + ":" + std::to_string(m_geosite.fingerprint)).value64();
+        }
+
+        bool geoipLoaded() const { return m_geoip.loaded; }
+        bool geositeLoaded() const { return m_geosite.loaded; }
+        size_t geoipCount() const { return m_geoip.entries.size(); }
+        size_t geositeCount() const { return m_geosite.entries.size(); }
+
+        // The serialized GeoIP / GeoSite message for |code|, read back from the
+        // file. Empty if absent or if the file changed since it was indexed.
+        std::string geoipEntry(std::string_view code) const { return read(m_geoip, code); }
+        std::string geositeEntry(std::string_view code) const { return read(m_geosite, code); }
+
+    private:
+        struct FileStamp {
+            bool exists = false;
+            uintmax_t size = 0;
+            std::filesystem::file_time_type writeTime{};
+
+            bool operator==(const FileStamp& other) const {
+                return exists == other.exists && size == other.size && writeTime == other.writeTime;
+            }
+            bool operator!=(const FileStamp& other) const { return !(*this == other); }
+        };
+
+        // Where an entry's bytes sit in the file.
+        struct Span {
+            uint64_t offset = 0;
+            uint64_t length = 0;
+        };
+
+        struct Table {
+            std::filesystem::path path; // empty until opened
+            FileStamp stamp;
+            bool loaded = false;
+            std::unordered_map<std::string, Span> entries;
+            uint64_t fingerprint = 0;
+        };
+
+        static FileStamp stamp_of(const std::filesystem::path& path) {
+            FileStamp stamp;
+            std::error_code ec;
+            stamp.size = std::filesystem::file_size(path, ec);
+            if (ec) return {};
+            stamp.writeTime = std::filesystem::last_write_time(path, ec);
+            if (ec) return {};
+            stamp.exists = true;
+            return stamp;
+        }
+
+        static bool changed(const Table& table) {
+            return !table.path.empty() && stamp_of(table.path) != table.stamp;
+        }
+
+        static std::string lower(std::string_view code) {
+            std::string out(code);
+            for (auto& c : out) {
+                if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+            }
+            return out;
+        }
+
+        static bool contains(const Table& table, std::string_view code) {
+            return !table.loaded || table.entries.count(lower(code)) != 0;
+        }
+
+        static std::string read(const Table& table, std::string_view code) {
+            auto it = table.entries.find(lower(code));
+            if (it == table.entries.end() || changed(table)) return {};
+            std::ifstream file(table.path, std::ios::binary);
+            std::string entry(static_cast<size_t>(it->second.length), '\0');
+            file.seekg(static_cast<std::streamoff>(it->second.offset));
+            if (!file.read(entry.data(), static_cast<std::streamsize>(entry.size()))) return {};
+            return entry;
+        }
+
+        // Replaces |table| with the file at |path|. A missing or malformed file
+        // leaves it unloaded and returns false.
+        static bool load(const std::filesystem::path& path, Table& table) {
+            table = Table{};
+            table.path = path;
+            // Stamped before reading, so a rewrite while indexing shows as stale.
+            table.stamp = stamp_of(path);
+            detail::MappedFile file;
+            if (!file.open(path)) return false;
+            const std::string_view data = file.view();
+            std::string codes;
+            const bool ok = detail::for_each_geo_entry(data, [&](std::string_view code, std::string_view entry) {
+                if (code.empty()) return;
+                auto key = lower(code);
+                codes += key;
+                codes += '\n';
+                table.entries.emplace(std::move(key), Span{ static_cast<uint64_t>(entry.data() - data.data()), entry.size() });
+            });
+            if (!ok) {
+                table.entries.clear();
+                return false;
+            }
+            table.loaded = true;
+            table.fingerprint = Utils::murmur3_128(codes).value64();
+            return true;
+        }
+
+        Table m_geoip;
+        Table m_geosite;
+    };
+}
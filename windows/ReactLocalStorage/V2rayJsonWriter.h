@@ -0,0 +1,243 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// =================================================================================
+// Streaming JSON writer for generated core configs
+// =================================================================================
+namespace V2rayConfigWin
+{
+    // Appends JSON text to a caller-owned buffer without building a DOM.
+    // Output matches nlohmann::json::dump(indent) for the same document, so
+    // compact (indent < 0) and pretty output can be compared against it
+    // directly; keys are written in the order the caller emits them.
+    //
+    // Strings are escaped like dump() with ensure_ascii = false. Invalid UTF-8
+    // is replaced with U+FFFD instead of throwing.
+    class JsonWriter {
+    public:
+        explicit JsonWriter(std::string& out, int indent = -1) : m_out(out), m_indent(indent) { m_counts.reserve(16); }
+
+        void beginObject() { open('{'); }
+        void endObject() { close('}'); }
+        void beginArray() { open('['); }
+        void endArray() { close(']'); }
+
+        void key(std::string_view name) {
+            separate();
+            append_string(name);
+            m_out += m_indent >= 0 ? ": " : ":";
+            m_afterKey = true;
+        }
+
+        void string(std::string_view text) {
+            separate();
+            append_string(text);
+        }
+
+        void number(long long value) {
+            separate();
+            char buffer[24];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, value);
+            m_out.append(buffer, end);
+        }
+
+        void boolean(bool value) {
+            separate();
+            m_out += value ? "true" : "false";
+        }
+
+        void null() {
+            separate();
+            m_out += "null";
+        }
+
+        // Writes an existing nlohmann value (settings blobs, outbounds) in place.
+        void value(const nlohmann::json& j) {
+            switch (j.type()) {
+                case nlohmann::json::value_t::object:
+                    beginObject();
+                    for (auto it = j.begin(); it != j.end(); ++it) {
+                        key(it.key());
+                        value(it.value());
+                    }
+                    endObject();
+                    break;
+                case nlohmann::json::value_t::array:
+                    beginArray();
+                    for (const auto& element : j) value(element);
+                    endArray();
+                    break;
+                case nlohmann::json::value_t::string:
+                    string(j.get_ref<const std::string&>());
+                    break;
+                case nlohmann::json::value_t::boolean:
+                    boolean(j.get<bool>());
+                    break;
+                case nlohmann::json::value_t::number_integer:
+                    number(j.get<long long>());
+                    break;
+                case nlohmann::json::value_t::number_unsigned: {
+                    separate();
+                    char buffer[24];
+                    auto [end, ec] = std::to_chars(buffer, buffer + sizeof buffer, j.get<unsigned long long>());
+                    m_out.append(buffer, end);
+                    break;
+                }
+                case nlohmann::json::value_t::number_float:
+                    separate();
+                    m_out += j.dump(); // rare; reuse nlohmann's float formatting
+                    break;
+                default:
+                    null();
+                    break;
+            }
+        }
+
+    private:
+        void separate() {
+            if (m_afterKey) {
+                m_afterKey = false;
+                return;
+            }
+            if (m_counts.empty()) return;
+            if (m_counts.back()++ > 0) m_out += ',';
+            newline(m_counts.size());
+        }
+
+        void newline(size_t depth) {
+            if (m_indent < 0) return;
+            m_out += '\n';
+            m_out.append(depth * static_cast<size_t>(m_indent), ' ');
+        }
+
+        void open(char bracket) {
+            separate();
+            m_out += bracket;
+            m_counts.push_back(0);
+        }
+
+        void close(char bracket) {
+            const bool empty = m_counts.back() == 0;
+            m_counts.pop_back();
+            if (!empty) newline(m_counts.size());
+            m_out += bracket;
+        }
+
+        // Length of the valid UTF-8 sequence at |s|[i], or 0 if it is invalid.
+        static size_t utf8_sequence_length(std::string_view s, size_t i) {
+            const auto byte = [&](size_t k) { return static_cast<uint8_t>(s[k]); };
+            const uint8_t lead = byte(i);
+            size_t length;
+            uint8_t min = 0x80, max = 0xBF; // bounds for the first continuation byte
+            if (lead >= 0xC2 && lead <= 0xDF) length = 2;
+            else if (lead >= 0xE0 && lead <= 0xEF) {
+                length = 3;
+                if (lead == 0xE0) min = 0xA0;      // overlong
+                else if (lead == 0xED) max = 0x9F; // surrogates
+            } else if (lead >= 0xF0 && lead <= 0xF4) {
+                length = 4;
+                if (lead == 0xF0) min = 0x90;      // overlong
+                else if (lead == 0xF4) max = 0x8F; // > U+10FFFF
+            } else {
+                return 0;
+            }
+            if (i + length > s.size()) return 0;
+            if (byte(i + 1) < min || byte(i + 1) > max) return 0;
+            for (size_t k = 2; k < length; ++k) {
+                if (byte(i + k) < 0x80 || byte(i + k) > 0xBF) return 0;
+            }
+            return length;
+        }
+
+        void append_string(std::string_view s) {
+            static constexpr char hex[] = "0123456789abcdef";
+            m_out += '"';
+            size_t run = 0; // start of the pending unescaped run
+            for (size_t i = 0; i < s.size();) {
+                const uint8_t c = static_cast<uint8_t>(s[i]);
+                if (c >= 0x20 && c != '"' && c != '\\' && c < 0x80) {
+                    ++i;
+                    continue;
+                }
+                if (c >= 0x80) {
+                    if (size_t length = utf8_sequence_length(s, i)) {
+                        i += length;
+                        continue;
+                    }
+                }
+                m_out.append(s.data() + run, i - run);
+                switch (c) {
+                    case '"': m_out += "\\\""; break;
+                    case '\\': m_out += "\\\\"; break;
+                    case '\b': m_out += "\\b"; break;
+                    case '\f': m_out += "\\f"; break;
+                    case '\n': m_out += "\\n"; break;
+                    case '\r': m_out += "\\r"; break;
+                    case '\t': m_out += "\\t"; break;
+                    default:
+                        if (c < 0x20) {
+                            m_out += "\\u00";
+                            m_out += hex[c >> 4];
+                            m_out += hex[c & 0xF];
+                        } else {
+                            m_out += "\xEF\xBF\xBD"; // U+FFFD for an invalid byte
+                        }
+                        break;
+                }
+                run = ++i;
+            }
+            m_out.append(s.data() + run, s.size() - run);
+            m_out += '"';
+        }
+
+        std::string& m_out;
+        int m_indent;
+        std::vector<size_t> m_counts; // members written so far, per open container
+        bool m_afterKey = false;
+    };
+
+    // Building blocks for the per-struct write_json overloads next to each DTO.
+    // Struct overloads are found by argument-dependent lookup, so they can live
+    // in the DTO's own namespace.
+    inline void write_json(JsonWriter& w, const std::string& v) { w.string(v); }
+    inline void write_json(JsonWriter& w, int v) { w.number(v); }
+    inline void write_json(JsonWriter& w, bool v) { w.boolean(v); }
+    inline void write_json(JsonWriter& w, const nlohmann::json& v) { w.value(v); }
+
+    inline void write_json(JsonWriter& w, const std::map<std::string, std::string>& v) {
+        w.beginObject();
+        for (const auto& [key, value] : v) {
+            w.key(key);
+            w.string(value);
+        }
+        w.endObject();
+    }
+
+    template <typename T>
+    inline void write_json(JsonWriter& w, const std::optional<T>& v) {
+        if (v) write_json(w, *v);
+        else w.null();
+    }
+
+    template <typename T>
+    inline void write_json(JsonWriter& w, const std::vector<T>& v) {
+        w.beginArray();
+        for (const auto& element : v) write_json(w, element);
+        w.endArray();
+    }
+
+    template <typename T>
+    inline void write_member(JsonWriter& w, std::string_view key, const T& v) {
+        w.key(key);
+        write_json(w, v);
+    }
+}
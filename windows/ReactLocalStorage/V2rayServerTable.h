@@ -0,0 +1,710 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "V2rayConfigWin.h"
+
+// =================================================================================
+// Compact server table
+// =================================================================================
+namespace V2rayConfigWin
+{
+    namespace detail {
+        // Native-endian, unaligned binary I/O for the on-disk server cache.
+        inline void put_bytes(std::string& out, const void* data, size_t size) {
+            out.append(static_cast<const char*>(data), size);
+        }
+
+        template <typename T>
+        inline void put(std::string& out, T value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            put_bytes(out, &value, sizeof value);
+        }
+
+        class ByteReader {
+        public:
+            ByteReader(const char* data, size_t size) : m_data(data), m_size(size) {}
+
+            // Returns the next |size| bytes in place, or nullptr if fewer remain.
+            const char* take(size_t size) {
+                if (size > m_size - m_pos) return nullptr;
+                const char* p = m_data + m_pos;
+                m_pos += size;
+                return p;
+            }
+
+            bool read(void* dst, size_t size) {
+                const char* src = take(size);
+                if (!src) return false;
+                if (size) std::memcpy(dst, src, size);
+                return true;
+            }
+
+            template <typename T>
+            bool read(T& value) { return read(&value, sizeof value); }
+
+            size_t remaining() const { return m_size - m_pos; }
+
+        private:
+            const char* m_data;
+            size_t m_size;
+            size_t m_pos = 0;
+        };
+    }
+
+    // Append-only interning pool. Every distinct string is stored once in a
+    // chunked arena and referred to by a 32-bit id; views stay valid for the
+    // lifetime of the pool. Id 0 is always the empty string.
+    class StringPool {
+    public:
+        using Id = uint32_t;
+        static constexpr Id kEmpty = 0;
+
+        StringPool() { m_strings.emplace_back(); }
+
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+        StringPool(StringPool&&) = default;
+        StringPool& operator=(StringPool&&) = default;
+
+        Id intern(std::string_view s) {
+            if (s.empty()) return kEmpty;
+            if (auto it = m_index.find(s); it != m_index.end()) return it->second;
+            std::string_view stored = store(s);
+            Id id = static_cast<Id>(m_strings.size());
+            m_strings.push_back(stored);
+            m_index.emplace(stored, id);
+            return id;
+        }
+
+        std::string_view view(Id id) const { return m_strings[id]; }
+        size_t size() const { return m_strings.size(); }
+
+        // Layout: u32 count, u32 length per string (ids 1..count-1), then the
+        // bytes back to back.
+        void writeTo(std::string& out) const {
+            detail::put<uint32_t>(out, static_cast<uint32_t>(m_strings.size()));
+            for (size_t id = 1; id < m_strings.size(); ++id) {
+                detail::put<uint32_t>(out, static_cast<uint32_t>(m_strings[id].size()));
+            }
+            for (size_t id = 1; id < m_strings.size(); ++id) {
+                detail::put_bytes(out, m_strings[id].data(), m_strings[id].size());
+            }
+        }
+
+        // Rebuilds an empty pool from writeTo() output read out of |buffer|.
+        // The pool takes |buffer| over as an arena chunk, so the strings are
+        // used in place rather than copied.
+        bool readFrom(detail::ByteReader& in, std::unique_ptr<char[]> buffer, size_t bufferSize) {
+            uint32_t count = 0;
+            if (!in.read(count) || count == 0 || count - 1 > in.remaining() / sizeof(uint32_t)) return false;
+            const char* lengths = in.take((count - 1) * sizeof(uint32_t));
+
+            std::vector<std::string_view> strings;
+            strings.reserve(count);
+            strings.emplace_back();
+            for (uint32_t id = 1; id < count; ++id) {
+                uint32_t length;
+                std::memcpy(&length, lengths + (id - 1) * sizeof(uint32_t), sizeof length);
+                const char* text = in.take(length);
+                if (!text || length == 0) return false;
+                strings.emplace_back(text, length);
+            }
+
+            m_index.clear();
+            m_index.reserve(count);
+            for (uint32_t id = 1; id < count; ++id) {
+                if (!m_index.emplace(strings[id], id).second) return false;
+            }
+            m_strings = std::move(strings);
+            m_chunks.push_back(std::move(buffer));
+            m_arenaBytes += bufferSize;
+            m_current = nullptr; // new strings start a fresh chunk
+            return true;
+        }
+
+        // Arena plus index, approximately.
+        size_t memoryBytes() const {
+            return m_arenaBytes + m_strings.capacity() * sizeof(std::string_view) +
+                   m_index.size() * (sizeof(std::string_view) + sizeof(Id) + 2 * sizeof(void*));
+        }
+
+    private:
+        static constexpr size_t kChunkSize = 64 * 1024;
+
+        std::string_view store(std::string_view s) {
+            if (s.size() > kChunkSize / 4) {
+                // Large strings get their own block so they don't waste a chunk tail.
+                m_chunks.push_back(std::make_unique<char[]>(s.size()));
+                m_arenaBytes += s.size();
+                std::memcpy(m_chunks.back().get(), s.data(), s.size());
+                return { m_chunks.back().get(), s.size() };
+            }
+            if (m_current == nullptr || m_chunkUsed + s.size() > kChunkSize) {
+                m_chunks.push_back(std::make_unique<char[]>(kChunkSize));
+                m_current = m_chunks.back().get();
+                m_chunkUsed = 0;
+                m_arenaBytes += kChunkSize;
+            }
+            char* dst = m_current + m_chunkUsed;
+            std::memcpy(dst, s.data(), s.size());
+            m_chunkUsed += s.size();
+            return { dst, s.size() };
+        }
+
+        std::vector<std::unique_ptr<char[]>> m_chunks;
+        char* m_current = nullptr;
+        size_t m_chunkUsed = 0;
+        size_t m_arenaBytes = 0;
+        std::vector<std::string_view> m_strings; // id -> text
+        std::unordered_map<std::string_view, Id> m_index;
+    };
+
+    // Column-oriented store for large server lists. Each field lives in its own
+    // vector (SoA) and strings are interned, so a row costs a few dozen bytes
+    // instead of a full ServerConfig with its nested optionals. Rows are turned
+    // back into ServerConfig only when needed (toServerConfig).
+    //
+    // Only the first vnext/user or server entry of a config is kept; share links
+    // never produce more than one.
+    class ServerTable {
+    public:
+        using Row = uint32_t;
+
+        Row add(const ServerConfig& config) {
+            const Row row = static_cast<Row>(m_type.size());
+            uint8_t flags = 0;
+
+            m_type.push_back(static_cast<uint8_t>(config.configType));
+            m_configVersion.push_back(static_cast<uint8_t>(config.configVersion));
+            m_addedTime.push_back(config.addedTime);
+            m_subscriptionId.push_back(m_strings.intern(config.subscriptionId));
+            m_remarks.push_back(m_strings.intern(config.remarks));
+
+            StringPool::Id protocol = StringPool::kEmpty, tag = StringPool::kEmpty;
+            StringPool::Id address = StringPool::kEmpty, credential = StringPool::kEmpty, security = StringPool::kEmpty;
+            StringPool::Id encryption = StringPool::kEmpty, flow = StringPool::kEmpty;
+            StringPool::Id network = StringPool::kEmpty, streamSecurity = StringPool::kEmpty;
+            StringPool::Id serverName = StringPool::kEmpty, tlsFingerprint = StringPool::kEmpty, alpn = StringPool::kEmpty;
+            int port = 0, alterId = 0;
+
+            if (config.outboundBean) {
+                const auto& outbound = *config.outboundBean;
+                protocol = m_strings.intern(outbound.protocol);
+                if (outbound.tag) { flags |= kHasTag; tag = m_strings.intern(*outbound.tag); }
+
+                if (outbound.settings && outbound.settings->vnext && !outbound.settings->vnext->empty()) {
+                    const auto& vnext = outbound.settings->vnext->front();
+                    address = m_strings.intern(vnext.address);
+                    port = vnext.port;
+                    if (!vnext.users.empty()) {
+                        const auto& user = vnext.users.front();
+                        credential = m_strings.intern(user.id);
+                        alterId = user.alterId;
+                        security = m_strings.intern(user.security);
+                        encryption = m_strings.intern(user.encryption);
+                        flow = m_strings.intern(user.flow);
+                    }
+                } else if (outbound.settings && outbound.settings->servers && !outbound.settings->servers->empty()) {
+                    const auto& server = outbound.settings->servers->front();
+                    address = m_strings.intern(server.address);
+                    port = server.port;
+                    credential = m_strings.intern(server.password);
+                    security = m_strings.intern(server.method);
+                    flow = m_strings.intern(server.flow);
+                }
+
+                if (outbound.streamSettings) {
+                    const auto& stream = *outbound.streamSettings;
+                    if (stream.network) { flags |= kHasNetwork; network = m_strings.intern(*stream.network); }
+                    if (stream.security) { flags |= kHasSecurity; streamSecurity = m_strings.intern(*stream.security); }
+                    if (stream.tlsSettings) {
+                        const auto& tls = *stream.tlsSettings;
+                        flags |= kHasTls;
+                        if (tls.allowInsecure.value_or(false)) flags |= kAllowInsecure;
+                        if (tls.serverName) { flags |= kHasServerName; serverName = m_strings.intern(*tls.serverName); }
+                        if (tls.fingerprint) tlsFingerprint = m_strings.intern(*tls.fingerprint);
+                        if (tls.alpn) {
+                            std::string joined;
+                            for (const auto& value : *tls.alpn) {
+                                if (!joined.empty()) joined += ',';
+                                joined += value;
+                            }
+                            flags |= kHasAlpn;
+                            alpn = m_strings.intern(joined);
+                        }
+                    }
+                }
+            }
+
+            m_protocol.push_back(protocol);
+            m_tag.push_back(tag);
+            m_address.push_back(address);
+            m_port.push_back(static_cast<uint16_t>(port));
+            m_credential.push_back(credential);
+            m_alterId.push_back(static_cast<uint16_t>(alterId));
+            m_security.push_back(security);
+            m_encryption.push_back(encryption);
+            m_flow.push_back(flow);
+            m_network.push_back(network);
+            m_streamSecurity.push_back(streamSecurity);
+            m_serverName.push_back(serverName);
+            m_tlsFingerprint.push_back(tlsFingerprint);
+            m_alpn.push_back(alpn);
+            m_flags.push_back(flags);
+            return row;
+        }
+
+        void addAll(const std::vector<ServerConfig>& configs) {
+            reserve(size() + configs.size());
+            for (const auto& config : configs) add(config);
+        }
+
+        void reserve(size_t rows) {
+            forEachColumn(*this, [rows](auto& column) { column.reserve(rows); });
+        }
+
+        size_t size() const { return m_type.size(); }
+
+        // Cheap per-row accessors for list rendering and filtering.
+        EConfigType type(Row row) const { return static_cast<EConfigType>(m_type[row]); }
+        std::string_view remarks(Row row) const { return m_strings.view(m_remarks[row]); }
+        std::string_view address(Row row) const { return m_strings.view(m_address[row]); }
+        int port(Row row) const { return m_port[row]; }
+        std::string_view subscriptionId(Row row) const { return m_strings.view(m_subscriptionId[row]); }
+
+        // Rebuilds the full ServerConfig for |row|.
+        ServerConfig toServerConfig(Row row) const {
+            const uint8_t flags = m_flags[row];
+            ServerConfig config = ServerConfig::create(type(row));
+            config.configVersion = m_configVersion[row];
+            config.addedTime = m_addedTime[row];
+            config.subscriptionId = std::string(m_strings.view(m_subscriptionId[row]));
+            config.remarks = std::string(remarks(row));
+
+            auto& outbound = *config.outboundBean;
+            outbound.protocol = std::string(m_strings.view(m_protocol[row]));
+            if (flags & kHasTag) outbound.tag = std::string(m_strings.view(m_tag[row]));
+
+            if (outbound.settings && outbound.settings->vnext && !outbound.settings->vnext->empty()) {
+                auto& vnext = outbound.settings->vnext->front();
+                vnext.address = std::string(address(row));
+                vnext.port = port(row);
+                auto& user = vnext.users.front();
+                user.id = std::string(m_strings.view(m_credential[row]));
+                user.alterId = m_alterId[row];
+                user.security = std::string(m_strings.view(m_security[row]));
+                user.encryption = std::string(m_strings.view(m_encryption[row]));
+                user.flow = std::string(m_strings.view(m_flow[row]));
+            } else if (outbound.settings && outbound.settings->servers && !outbound.settings->servers->empty()) {
+                auto& server = outbound.settings->servers->front();
+                server.address = std::string(address(row));
+                server.port = port(row);
+                server.password = std::string(m_strings.view(m_credential[row]));
+                server.method = std::string(m_strings.view(m_security[row]));
+                server.flow = std::string(m_strings.view(m_flow[row]));
+            }
+
+            auto& stream = *outbound.streamSettings;
+            if (flags & kHasNetwork) stream.network = std::string(m_strings.view(m_network[row]));
+            if (flags & kHasSecurity) stream.security = std::string(m_strings.view(m_streamSecurity[row]));
+            if (flags & kHasTls) {
+                V2rayConfig::TlsSettings tls;
+                tls.allowInsecure = (flags & kAllowInsecure) != 0;
+                if (flags & kHasServerName) tls.serverName = std::string(m_strings.view(m_serverName[row]));
+                if (m_tlsFingerprint[row] != StringPool::kEmpty) tls.fingerprint = std::string(m_strings.view(m_tlsFingerprint[row]));
+                if (flags & kHasAlpn) tls.alpn = Utils::split(m_strings.view(m_alpn[row]), ',');
+                stream.tlsSettings = std::move(tls);
+            }
+            return config;
+        }
+
+        size_t memoryBytes() const {
+            size_t bytes = m_strings.memoryBytes();
+            forEachColumn(*this, [&bytes](const auto& column) { bytes += column.capacity() * sizeof(column[0]); });
+            return bytes;
+        }
+
+        // Layout: the string pool, u32 row count, then every column as a raw
+        // array in forEachColumn() order.
+        void writeTo(std::string& out) const {
+            m_strings.writeTo(out);
+            detail::put<uint32_t>(out, static_cast<uint32_t>(size()));
+            forEachColumn(*this, [&out](const auto& column) {
+                detail::put_bytes(out, column.data(), column.size() * sizeof(column[0]));
+            });
+        }
+
+        // Reads writeTo() output from |in|, which points into |buffer|; see
+        // StringPool::readFrom. Returns nullopt on truncated or inconsistent
+        // input, including string ids that are out of range.
+        static std::optional<ServerTable> readFrom(detail::ByteReader& in, std::unique_ptr<char[]> buffer, size_t bufferSize) {
+            ServerTable table;
+            if (!table.m_strings.readFrom(in, std::move(buffer), bufferSize)) return std::nullopt;
+
+            uint32_t rows = 0;
+            if (!in.read(rows)) return std::nullopt;
+            bool ok = true;
+            const size_t strings = table.m_strings.size();
+            forEachColumn(table, [&](auto& column) {
+                using T = typename std::decay_t<decltype(column)>::value_type;
+                if (!ok || rows > in.remaining() / sizeof(T)) { ok = false; return; }
+                column.resize(rows);
+                in.read(column.data(), rows * sizeof(T));
+                if constexpr (std::is_same_v<T, StringPool::Id>) {
+                    for (StringPool::Id id : column) ok = ok && id < strings;
+                }
+            });
+            for (uint8_t type : table.m_type) {
+                ok = ok && type >= static_cast<uint8_t>(EConfigType::VMESS) && type <= static_cast<uint8_t>(EConfigType::WIREGUARD);
+            }
+            if (!ok) return std::nullopt;
+            return table;
+        }
+
+    private:
+        // Every column, in serialization order.
+        template <typename Self, typename Fn>
+        static void forEachColumn(Self& self, Fn&& fn) {
+            fn(self.m_type); fn(self.m_configVersion); fn(self.m_addedTime); fn(self.m_subscriptionId);
+            fn(self.m_remarks); fn(self.m_protocol); fn(self.m_tag); fn(self.m_address); fn(self.m_port);
+            fn(self.m_credential); fn(self.m_alterId); fn(self.m_security); fn(self.m_encryption);
+            fn(self.m_flow); fn(self.m_network); fn(self.m_streamSecurity); fn(self.m_serverName);
+            fn(self.m_tlsFingerprint); fn(self.m_alpn); fn(self.m_flags);
+        }
+
+        enum : uint8_t {
+            kHasTag = 1 << 0,
+            kHasNetwork = 1 << 1,
+            kHasSecurity = 1 << 2,
+            kHasTls = 1 << 3,
+            kAllowInsecure = 1 << 4,
+            kHasServerName = 1 << 5,
+            kHasAlpn = 1 << 6,
+        };
+
+        StringPool m_strings;
+
+        std::vector<uint8_t> m_type;
+        std::vector<uint8_t> m_configVersion;
+        std::vector<long long> m_addedTime;
+        std::vector<StringPool::Id> m_subscriptionId;
+        std::vector<StringPool::Id> m_remarks;
+        std::vector<StringPool::Id> m_protocol;
+        std::vector<StringPool::Id> m_tag;
+        std::vector<StringPool::Id> m_address;
+        std::vector<uint16_t> m_port;
+        std::vector<StringPool::Id> m_credential; // vnext user id, or server password
+        std::vector<uint16_t> m_alterId;
+        std::vector<StringPool::Id> m_security;   // vnext user security, or server method
+        std::vector<StringPool::Id> m_encryption;
+        std::vector<StringPool::Id> m_flow;
+        std::vector<StringPool::Id> m_network;
+        std::vector<StringPool::Id> m_streamSecurity;
+        std::vector<StringPool::Id> m_serverName;
+        std::vector<StringPool::Id> m_tlsFingerprint;
+        std::vector<StringPool::Id> m_alpn;       // comma-joined
+        std::vector<uint8_t> m_flags;
+    };
+
+    // =================================================================================
+    // Cache files
+    // =================================================================================
+
+    // Outcome of loading or saving one of the persistent caches. A failed load
+    // leaves the cache empty; a failed save leaves the previous file in place.
+    enum class CacheFileStatus {
+        Ok = 0,
+        Missing,          // no file, or it couldn't be read
+        Stale,            // other magic, version or size, e.g. after an upgrade
+        ChecksumMismatch, // payload damaged on disk
+        Malformed,        // payload checksum matches but doesn't parse
+        WriteFailed,      // the temporary file couldn't be written
+        ReplaceFailed,    // the temporary file couldn't be renamed over the cache
+    };
+
+    struct CacheFileResult {
+        CacheFileStatus status = CacheFileStatus::Ok;
+        std::error_code error; // set for ReplaceFailed
+        explicit operator bool() const { return status == CacheFileStatus::Ok; }
+    };
+
+    namespace detail {
+        // Framing shared by the cache files (native endian):
+        //   magic[4] | u32 version | u64 payload size | u64 payload checksum
+        // The checksum is the low half of the payload's murmur3_128.
+        constexpr size_t kCacheHeaderSize = 4 + sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+        // Reads the file at |path| in a single read into |buffer|. On success
+        // the payload is |buffer| past kCacheHeaderSize, |size| bytes in all.
+        inline CacheFileStatus read_cache_file(const std::filesystem::path& path, const char (&magic)[4], uint32_t version,
+                                               std::unique_ptr<char[]>& buffer, size_t& size) {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file) return CacheFileStatus::Missing;
+            const std::streamoff fileSize = file.tellg();
+            if (fileSize < static_cast<std::streamoff>(kCacheHeaderSize)) return CacheFileStatus::Stale;
+
+            size = static_cast<size_t>(fileSize);
+            buffer = std::make_unique<char[]>(size);
+            file.seekg(0);
+            if (!file.read(buffer.get(), fileSize)) return CacheFileStatus::Missing;
+
+            ByteReader header(buffer.get(), kCacheHeaderSize);
+            char fileMagic[4];
+            uint32_t fileVersion = 0;
+            uint64_t payloadSize = 0, checksum = 0;
+            header.read(fileMagic, sizeof fileMagic);
+            header.read(fileVersion);
+            header.read(payloadSize);
+            header.read(checksum);
+            if (std::memcmp(fileMagic, magic, sizeof fileMagic) != 0 || fileVersion != version) return CacheFileStatus::Stale;
+            if (payloadSize != size - kCacheHeaderSize) return CacheFileStatus::Stale;
+
+            const std::string_view payload(buffer.get() + kCacheHeaderSize, size - kCacheHeaderSize);
+            if (Utils::murmur3_128(payload).value64() != checksum) return CacheFileStatus::ChecksumMismatch;
+            return CacheFileStatus::Ok;
+        }
+
+        // Frames |payload| into a temporary file next to |path| and renames it
+        // over |path|, so an interrupted save never leaves a half-written cache.
+        inline CacheFileResult write_cache_file(const std::filesystem::path& path, const char (&magic)[4], uint32_t version,
+                                                std::string_view payload) {
+            std::string header;
+            put_bytes(header, magic, sizeof magic);
+            put<uint32_t>(header, version);
+            put<uint64_t>(header, payload.size());
+            put<uint64_t>(header, Utils::murmur3_128(payload).value64());
+
+            std::filesystem::path temp = path;
+            temp += ".tmp";
+            {
+                std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+                file.write(header.data(), static_cast<std::streamsize>(header.size()));
+                file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                if (!file.flush()) return CacheFileResult{ CacheFileStatus::WriteFailed, {} };
+            }
+            CacheFileResult result;
+            std::filesystem::rename(temp, path, result.error);
+            if (result.error) {
+                result.status = CacheFileStatus::ReplaceFailed;
+                std::error_code ignored;
+                std::filesystem::remove(temp, ignored);
+            }
+            return result;
+        }
+    }
+
+    // =================================================================================
+    // Persistent parse cache
+    // =================================================================================
+
+    // Share link -> parsed server memo, persisted between launches so that a
+    // subscription refresh only parses the links it hasn't seen before. Keys are
+    // the murmur3_128 of the link text; values are rows of a ServerTable.
+    //
+    // File payload (framed by write_cache_file as "V2SC", kFormatVersion):
+    //   u32 rows | rows x (u64 low, u64 high) link hashes | ServerTable
+    // The string pool is used in place in the loaded file, so loading is
+    // dominated by the disk read.
+    class ServerCache : public AngConfigManager::LinkCache {
+    public:
+        // Bump whenever the layout or what the parsers produce for a link changes;
+        // a file with any other version is ignored and rebuilt.
+        static constexpr uint32_t kFormatVersion = 1;
+        static constexpr char kMagic[4] = { 'V', '2', 'S', 'C' };
+        static constexpr size_t kDefaultCapacity = 10000;
+
+        // Holds at most |capacity| links. A store past that evicts the least
+        // recently looked-up or stored eighth of them in one go.
+        explicit ServerCache(size_t capacity = kDefaultCapacity) : m_capacity(capacity) {}
+
+        // Safe to call from several threads at once, as importBatch's workers
+        // do, as long as nothing modifies the cache meanwhile.
+        bool lookup(std::string_view link, ServerConfig& out) const override {
+            auto it = m_rows.find(Utils::murmur3_128(link));
+            if (it == m_rows.end()) return false;
+            std::atomic_ref<uint64_t>(m_lastUse[it->second]).store(m_clock.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+            out = m_table.toServerConfig(it->second);
+            return true;
+        }
+
+        void store(std::string_view link, const ServerConfig& config) override {
+            auto [it, inserted] = m_rows.try_emplace(Utils::murmur3_128(link), 0);
+            if (!inserted) return;
+            it->second = m_table.add(config);
+            m_keys.push_back(it->first);
+            m_lastUse.push_back(m_clock.fetch_add(1, std::memory_order_relaxed));
+            m_dirty = true;
+            if (m_keys.size() > m_capacity) trim(m_capacity - m_capacity / 8);
+        }
+
+        size_t size() const { return m_keys.size(); }
+        size_t capacity() const { return m_capacity; }
+        bool dirty() const { return m_dirty; }
+        size_t memoryBytes() const {
+            return m_table.memoryBytes() + m_keys.capacity() * sizeof(ServerFingerprint) + m_lastUse.capacity() * sizeof(uint64_t) +
+                   m_rows.size() * (sizeof(ServerFingerprint) + sizeof(ServerTable::Row) + 2 * sizeof(void*));
+        }
+
+        void clear() {
+            m_table = ServerTable{};
+            m_keys.clear();
+            m_lastUse.clear();
+            m_rows.clear();
+            m_clock.store(0, std::memory_order_relaxed);
+            m_dirty = false;
+            m_partial = false;
+        }
+
+        // Keeps only the |maxRows| most recently used links.
+        void trim(size_t maxRows) {
+            if (m_keys.size() <= maxRows) return;
+            rebuild(maxRows);
+            m_dirty = true;
+        }
+
+        // Evicts least recently used links until memoryBytes() is about
+        // |targetBytes|; 0 empties the cache. Meant for memory pressure: the
+        // evicted links stay in the file, and save() keeps them there.
+        void trimToBytes(size_t targetBytes) {
+            const size_t bytes = memoryBytes();
+            if (bytes <= targetBytes) return;
+            const size_t maxRows = static_cast<size_t>(static_cast<double>(m_keys.size()) * static_cast<double>(targetBytes) / static_cast<double>(bytes));
+            if (m_keys.size() <= maxRows) return;
+            rebuild(maxRows);
+            m_partial = true;
+        }
+
+        // Replaces the contents with the file at |path|. Any failure leaves the
+        // cache empty; callers simply fall back to parsing.
+        CacheFileResult load(const std::filesystem::path& path) {
+            clear();
+            std::unique_ptr<char[]> buffer;
+            size_t size = 0;
+            if (auto status = detail::read_cache_file(path, kMagic, kFormatVersion, buffer, size); status != CacheFileStatus::Ok) {
+                return CacheFileResult{ status, {} };
+            }
+
+            detail::ByteReader in(buffer.get() + detail::kCacheHeaderSize, size - detail::kCacheHeaderSize);
+            uint32_t rows = 0;
+            if (!in.read(rows) || rows > in.remaining() / (2 * sizeof(uint64_t))) return CacheFileResult{ CacheFileStatus::Malformed, {} };
+            std::vector<ServerFingerprint> keys(rows);
+            for (auto& key : keys) {
+                in.read(key.low);
+                in.read(key.high);
+            }
+
+            auto table = ServerTable::readFrom(in, std::move(buffer), size);
+            if (!table || table->size() != rows || in.remaining() != 0) return CacheFileResult{ CacheFileStatus::Malformed, {} };
+
+            m_rows.reserve(rows);
+            for (ServerTable::Row row = 0; row < rows; ++row) {
+                if (!m_rows.try_emplace(keys[row], row).second) {
+                    m_rows.clear();
+                    return CacheFileResult{ CacheFileStatus::Malformed, {} };
+                }
+            }
+            m_table = std::move(*table);
+            m_keys = std::move(keys);
+            // Saved oldest first, so the row order doubles as recency.
+            m_lastUse.resize(rows);
+            std::iota(m_lastUse.begin(), m_lastUse.end(), uint64_t{0});
+            m_clock.store(rows, std::memory_order_relaxed);
+            trim(m_capacity);
+            return {};
+        }
+
+        // Replaces the file at |path| atomically (see write_cache_file). Rows are
+        // written oldest first, which is how load() recovers recency. Links that
+        // trimToBytes() dropped are carried over from the existing file as its
+        // oldest rows, so memory pressure alone never shrinks the file.
+        CacheFileResult save(const std::filesystem::path& path) {
+            if (!m_partial) return write(path);
+
+            // Whatever of the old file still reads; a broken one only loses the evicted links.
+            ServerCache merged(m_capacity);
+            merged.load(path);
+            if (!std::is_sorted(m_lastUse.begin(), m_lastUse.end())) rebuild(m_keys.size());
+            for (ServerTable::Row row = 0; row < m_keys.size(); ++row) {
+                const uint64_t now = merged.m_clock.fetch_add(1, std::memory_order_relaxed);
+                auto [it, inserted] = merged.m_rows.try_emplace(m_keys[row], 0);
+                if (!inserted) {
+                    merged.m_lastUse[it->second] = now;
+                    continue;
+                }
+                it->second = merged.m_table.add(m_table.toServerConfig(row));
+                merged.m_keys.push_back(m_keys[row]);
+                merged.m_lastUse.push_back(now);
+            }
+            merged.trim(m_capacity);
+            auto result = merged.write(path);
+            if (result) m_dirty = false;
+            return result;
+        }
+
+    private:
+        CacheFileResult write(const std::filesystem::path& path) {
+            if (!std::is_sorted(m_lastUse.begin(), m_lastUse.end())) rebuild(m_keys.size());
+            std::string payload;
+            detail::put<uint32_t>(payload, static_cast<uint32_t>(m_keys.size()));
+            for (const auto& key : m_keys) {
+                detail::put<uint64_t>(payload, key.low);
+                detail::put<uint64_t>(payload, key.high);
+            }
+            m_table.writeTo(payload);
+
+            auto result = detail::write_cache_file(path, kMagic, kFormatVersion, payload);
+            if (result) m_dirty = false;
+            return result;
+        }
+
+        // Rebuilds the table from the |maxRows| most recently used rows,
+        // oldest first.
+        void rebuild(size_t maxRows) {
+            std::vector<ServerTable::Row> order(m_keys.size());
+            std::iota(order.begin(), order.end(), ServerTable::Row{0});
+            std::sort(order.begin(), order.end(), [&](ServerTable::Row a, ServerTable::Row b) { return m_lastUse[a] < m_lastUse[b]; });
+            order.erase(order.begin(), order.end() - static_cast<std::ptrdiff_t>((std::min)(maxRows, order.size())));
+
+            ServerTable table;
+            std::vector<ServerFingerprint> keys;
+            std::vector<uint64_t> lastUse;
+            std::unordered_map<ServerFingerprint, ServerTable::Row, ServerFingerprintHash> rows;
+            keys.reserve(order.size());
+            lastUse.reserve(order.size());
+            rows.reserve(order.size());
+            for (ServerTable::Row row : order) {
+                rows.emplace(m_keys[row], table.add(m_table.toServerConfig(row)));
+                keys.push_back(m_keys[row]);
+                lastUse.push_back(m_lastUse[row]);
+            }
+            m_table = std::move(table);
+            m_keys = std::move(keys);
+            m_lastUse = std::move(lastUse);
+            m_rows = std::move(rows);
+        }
+
+        ServerTable m_table;
+        std::vector<ServerFingerprint> m_keys; // row -> link hash, for save()
+        mutable std::vector<uint64_t> m_lastUse; // row -> m_clock at its last use
+        std::unordered_map<ServerFingerprint, ServerTable::Row, ServerFingerprintHash> m_rows;
+        mutable std::atomic<uint64_t> m_clock{0};
+        size_t m_capacity;
+        bool m_dirty = false;
+        bool m_partial = false; // trimToBytes() dropped links the file may still hold
+    };
+}
@@ -21,4 +21,21 @@ struct ReactLocalStorageSpec_V2Config {
     std::string content;
 };
 
+struct ReactLocalStorageSpec_MemoryFootprint {
+    double sqliteHeapBytes;
+    double sqliteHeapHighwater;
+    double sqliteSoftHeapLimit;
+    double pageCacheKiB;
+    double cacheBytes;
+    double cacheBudgetBytes;
+    double pressureLevel;
+};
+
+struct ReactLocalStorageSpec_SubscriptionImport {
+    double imported;
+    double failed;
+    double duplicates;
+    double cacheHits;
+};
+
 } // namespace ReactLocalStorageCodegen
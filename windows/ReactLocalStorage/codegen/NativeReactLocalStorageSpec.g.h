@@ -23,6 +23,29 @@ inline winrt::Microsoft::ReactNative::FieldMap GetStructInfo(ReactLocalStorageSp
     return fieldMap;
 }
 
+inline winrt::Microsoft::ReactNative::FieldMap GetStructInfo(ReactLocalStorageSpec_MemoryFootprint*) noexcept {
+    winrt::Microsoft::ReactNative::FieldMap fieldMap {
+        {L"sqliteHeapBytes", &ReactLocalStorageSpec_MemoryFootprint::sqliteHeapBytes},
+        {L"sqliteHeapHighwater", &ReactLocalStorageSpec_MemoryFootprint::sqliteHeapHighwater},
+        {L"sqliteSoftHeapLimit", &ReactLocalStorageSpec_MemoryFootprint::sqliteSoftHeapLimit},
+        {L"pageCacheKiB", &ReactLocalStorageSpec_MemoryFootprint::pageCacheKiB},
+        {L"cacheBytes", &ReactLocalStorageSpec_MemoryFootprint::cacheBytes},
+        {L"cacheBudgetBytes", &ReactLocalStorageSpec_MemoryFootprint::cacheBudgetBytes},
+        {L"pressureLevel", &ReactLocalStorageSpec_MemoryFootprint::pressureLevel},
+    };
+    return fieldMap;
+}
+
+inline winrt::Microsoft::ReactNative::FieldMap GetStructInfo(ReactLocalStorageSpec_SubscriptionImport*) noexcept {
+    winrt::Microsoft::ReactNative::FieldMap fieldMap {
+        {L"imported", &ReactLocalStorageSpec_SubscriptionImport::imported},
+        {L"failed", &ReactLocalStorageSpec_SubscriptionImport::failed},
+        {L"duplicates", &ReactLocalStorageSpec_SubscriptionImport::duplicates},
+        {L"cacheHits", &ReactLocalStorageSpec_SubscriptionImport::cacheHits},
+    };
+    return fieldMap;
+}
+
 struct ReactLocalStorageSpec : winrt::Microsoft::ReactNative::TurboModuleSpec {
   static constexpr auto methods = std::tuple{
       SyncMethod<double(double, double) noexcept>{0, L"multiply"},
@@ -41,6 +64,20 @@ struct ReactLocalStorageSpec : winrt::Microsoft::ReactNative::TurboModuleSpec {
       Method<void(std::string) noexcept>{13, L"setUnlimited"},
       Method<void() noexcept>{14, L"addReward"},
       Method<void(std::string) noexcept>{15, L"copyTheInviteCode"},
+      Method<void(double, std::string) noexcept>{16, L"setDouble"},
+      SyncMethod<std::optional<double>(std::string) noexcept>{17, L"getDouble"},
+      Method<void(double, std::string) noexcept>{18, L"setInt64"},
+      SyncMethod<std::optional<double>(std::string) noexcept>{19, L"getInt64"},
+      SyncMethod<std::optional<double>(std::string, double) noexcept>{20, L"incrementInt64"},
+      Method<void(bool, std::string) noexcept>{21, L"setBool"},
+      SyncMethod<std::optional<bool>(std::string) noexcept>{22, L"getBool"},
+      Method<void(std::string) noexcept>{23, L"enableSearchIndex"},
+      Method<void(std::string) noexcept>{24, L"disableSearchIndex"},
+      Method<void(std::string, std::string, double, Promise<std::vector<std::string>>) noexcept>{25, L"search"},
+      Method<void(std::string, Promise<double>) noexcept>{26, L"importAsyncStorageDump"},
+      Method<void(double) noexcept>{27, L"reportMemoryPressure"},
+      SyncMethod<ReactLocalStorageSpec_MemoryFootprint() noexcept>{28, L"getMemoryFootprint"},
+      Method<void(std::string, Promise<ReactLocalStorageSpec_SubscriptionImport>) noexcept>{29, L"importSubscription"},
   };
 
   template <class TModule>
@@ -127,6 +164,76 @@ struct ReactLocalStorageSpec : winrt::Microsoft::ReactNative::TurboModuleSpec {
           "copyTheInviteCode",
           "    REACT_METHOD(copyTheInviteCode) void copyTheInviteCode(std::string code) noexcept { /* implementation */ }\n"
           "    REACT_METHOD(copyTheInviteCode) static void copyTheInviteCode(std::string code) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          16,
+          "setDouble",
+          "    REACT_METHOD(setDouble) void setDouble(double value, std::string key) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(setDouble) static void setDouble(double value, std::string key) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          17,
+          "getDouble",
+          "    REACT_SYNC_METHOD(getDouble) std::optional<double> getDouble(std::string key) noexcept { /* implementation */ }\n"
+          "    REACT_SYNC_METHOD(getDouble) static std::optional<double> getDouble(std::string key) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          18,
+          "setInt64",
+          "    REACT_METHOD(setInt64) void setInt64(double value, std::string key) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(setInt64) static void setInt64(double value, std::string key) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          19,
+          "getInt64",
+          "    REACT_SYNC_METHOD(getInt64) std::optional<double> getInt64(std::string key) noexcept { /* implementation */ }\n"
+          "    REACT_SYNC_METHOD(getInt64) static std::optional<double> getInt64(std::string key) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          20,
+          "incrementInt64",
+          "    REACT_SYNC_METHOD(incrementInt64) std::optional<double> incrementInt64(std::string key, double delta) noexcept { /* implementation */ }\n"
+          "    REACT_SYNC_METHOD(incrementInt64) static std::optional<double> incrementInt64(std::string key, double delta) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          21,
+          "setBool",
+          "    REACT_METHOD(setBool) void setBool(bool value, std::string key) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(setBool) static void setBool(bool value, std::string key) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          22,
+          "getBool",
+          "    REACT_SYNC_METHOD(getBool) std::optional<bool> getBool(std::string key) noexcept { /* implementation */ }\n"
+          "    REACT_SYNC_METHOD(getBool) static std::optional<bool> getBool(std::string key) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          23,
+          "enableSearchIndex",
+          "    REACT_METHOD(enableSearchIndex) void enableSearchIndex(std::string prefix) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(enableSearchIndex) static void enableSearchIndex(std::string prefix) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          24,
+          "disableSearchIndex",
+          "    REACT_METHOD(disableSearchIndex) void disableSearchIndex(std::string prefix) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(disableSearchIndex) static void disableSearchIndex(std::string prefix) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          25,
+          "search",
+          "    REACT_METHOD(search) void search(std::string prefix, std::string query, double limit, ::React::ReactPromise<std::vector<std::string>> &&result) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(search) static void search(std::string prefix, std::string query, double limit, ::React::ReactPromise<std::vector<std::string>> &&result) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          26,
+          "importAsyncStorageDump",
+          "    REACT_METHOD(importAsyncStorageDump) void importAsyncStorageDump(std::string path, ::React::ReactPromise<double> &&result) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(importAsyncStorageDump) static void importAsyncStorageDump(std::string path, ::React::ReactPromise<double> &&result) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          27,
+          "reportMemoryPressure",
+          "    REACT_METHOD(reportMemoryPressure) void reportMemoryPressure(double level) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(reportMemoryPressure) static void reportMemoryPressure(double level) noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          28,
+          "getMemoryFootprint",
+          "    REACT_SYNC_METHOD(getMemoryFootprint) ReactLocalStorageSpec_MemoryFootprint getMemoryFootprint() noexcept { /* implementation */ }\n"
+          "    REACT_SYNC_METHOD(getMemoryFootprint) static ReactLocalStorageSpec_MemoryFootprint getMemoryFootprint() noexcept { /* implementation */ }\n");
+    REACT_SHOW_METHOD_SPEC_ERRORS(
+          29,
+          "importSubscription",
+          "    REACT_METHOD(importSubscription) void importSubscription(std::string subscription, ::React::ReactPromise<ReactLocalStorageSpec_SubscriptionImport> &&result) noexcept { /* implementation */ }\n"
+          "    REACT_METHOD(importSubscription) static void importSubscription(std::string subscription, ::React::ReactPromise<ReactLocalStorageSpec_SubscriptionImport> &&result) noexcept { /* implementation */ }\n");
   }
 };
 